@@ -0,0 +1,136 @@
+/**
+ * Utilities to adaptively repartition the work among the workers of the
+ * std::thread frameworks, based on the time each worker spent on its stripe
+ * during the last steps.
+ */
+#ifndef BALANCE_HPP
+#define BALANCE_HPP
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * Class keeping track of the per-worker step times and moving the stripe
+ * boundaries toward balance
+ *
+ * Boundaries are stored as nw + 1 half-open limits, worker i owning the units
+ * (cells or rows) in [bounds[i], bounds[i + 1]).
+ */
+class Balancer {
+  private:
+    // number of workers
+    int nw;
+    // number of units to be divided
+    long units;
+    // smoothed compute time of each worker in microseconds
+    vector<double> times;
+    // number of steps between two rebalancing checks
+    int period;
+    // minimum imbalance (max / avg - 1) needed to move the boundaries
+    double threshold;
+    // weight of the last sample in the moving average
+    double alpha;
+    // steps elapsed since the last check
+    int elapsed;
+
+  public:
+    // Default constructor, dividing no units
+    Balancer(): nw(0), units(0), period(8), threshold(0.1), alpha(0.5), elapsed(0) {}
+
+    // Constructor
+    Balancer(int nw, long units, int period = 8, double threshold = 0.1, double alpha = 0.5):
+      nw(nw), units(units), period(period), threshold(threshold), alpha(alpha) {
+        times = vector<double>(nw, 0);
+        elapsed = 0;
+    }
+
+    /**
+     * Computes the static partition, splitting the units evenly and assigning
+     * the remainder to the last worker
+     *
+     * @returns the nw + 1 boundaries of the stripes
+     */
+    vector<long> evenBounds() {
+      vector<long> bounds(nw + 1);
+      long offset = units / nw;
+      for (int i = 0; i < nw; i++) {
+        bounds[i] = i * offset;
+      }
+      bounds[nw] = units;
+      return bounds;
+    }
+
+    /**
+     * Records the compute time of a worker for the last step
+     *
+     * @param id index of the worker
+     * @param us time spent computing its stripe, in microseconds
+     */
+    void record(int id, double us) {
+      if (times[id] == 0) times[id] = us;
+      else times[id] = alpha * us + (1 - alpha) * times[id];
+    }
+
+    /**
+     * Called once per step, when all workers are waiting at the barrier.
+     * Every period steps, if the imbalance exceeds the threshold, moves the
+     * boundaries so that the estimated time of each stripe is the same
+     *
+     * @param bounds the current boundaries, updated in place
+     * @returns true if the boundaries have been moved
+     */
+    bool rebalance(vector<long>& bounds) {
+      if (++elapsed < period) return false;
+      elapsed = 0;
+
+      double total = 0;
+      double max = 0;
+      for (int i = 0; i < nw; i++) {
+        total += times[i];
+        if (times[i] > max) max = times[i];
+      }
+      if (total <= 0 || max / (total / nw) - 1 < threshold) return false;
+
+      // cost of a unit in each stripe, assumed uniform inside the stripe
+      vector<double> density(nw);
+      for (int i = 0; i < nw; i++) {
+        long len = bounds[i + 1] - bounds[i];
+        density[i] = len > 0 ? times[i] / len : 0;
+      }
+
+      // walk the cumulative cost and cut it in nw equal parts
+      vector<long> nBounds(nw + 1);
+      nBounds[0] = 0;
+      nBounds[nw] = units;
+      double target = total / nw;
+      double acc = 0;
+      int k = 1;
+      for (int i = 0; i < nw && k < nw; i++) {
+        double next = acc + times[i];
+        while (k < nw && next >= k * target) {
+          long cut = bounds[i];
+          if (density[i] > 0) cut += (long) ((k * target - acc) / density[i]);
+          nBounds[k++] = cut < bounds[i + 1] ? cut : bounds[i + 1];
+        }
+        acc = next;
+      }
+      while (k < nw) nBounds[k++] = units;
+
+      // every worker keeps at least one unit when possible
+      long minLen = units >= nw ? 1 : 0;
+      for (int i = 1; i < nw; i++) {
+        if (nBounds[i] < nBounds[i - 1] + minLen) nBounds[i] = nBounds[i - 1] + minLen;
+        if (nBounds[i] > units - (nw - i) * minLen) nBounds[i] = units - (nw - i) * minLen;
+      }
+
+      // the stripes changed, so the old samples are not meaningful anymore
+      for (int i = 0; i < nw; i++) {
+        times[i] = 0;
+      }
+      bounds = nBounds;
+      return true;
+    }
+};
+
+#endif
@@ -0,0 +1,446 @@
+/**
+ * Benchmark driver running the engines and table implementations of the
+ * framework over a matrix of configurations (engine x table x grid size x
+ * workers x steps x input workload) in a single invocation, and writing the
+ * results as CSV or JSON. The inputs are taken from the corpus of workloads.hpp.
+ *
+ * The runs can be saved in the results database of regressions.hpp, under the
+ * fingerprint of the host and the git revision, and compared against the runs
+ * of a baseline revision, the exit status being 1 if any configuration is
+ * significantly slower. With --stored the runs of a revision are taken from the
+ * database instead of being executed, e.g.
+ *   ./bench --save on                       (on the baseline, repeated as needed)
+ *   ./bench --save on --baseline <revision> (on the change)
+ *   ./bench --stored <revision> --baseline <revision>
+ *
+ * Compile from the root of the repository with
+ *   g++ -std=c++14 -O3 -pthread -I. bench.cpp -o bench
+ * adding -DFF and the include path of FastFlow to also run the FastFlow engines.
+ *
+ * The engines are compiled side by side as in bench_engines.hpp.
+ */
+#include <iostream>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_engines.hpp"
+#include "workloads.hpp"
+#include "regressions.hpp"
+
+/**
+ * Attaches the counters to the engines able to count the events of their workers
+ */
+template<class T>
+auto attachCounters(T& game, PerfCounters* counters, int) -> decltype(game.setCounters(counters), void()) {
+  game.setCounters(counters);
+}
+template<class T>
+void attachCounters(T&, PerfCounters*, long) {}
+
+/**
+ * Runs a game on the given input, excluding its construction from the timing
+ *
+ * @param overhead set to the overhead returned by run()
+ * @param counters counters of the workers, nullptr if not counted
+ * @returns the duration of the run in microseconds
+ */
+template<class T>
+double timeRun(long height, long width, int nw, int steps, const vector<int>& input, double& overhead,
+               PerfCounters* counters) {
+  T game(height, width, nw, input);
+  if (counters != nullptr) attachCounters(game, counters, 0);
+  auto startTime = Clock::now();
+  overhead = game.run(steps);
+  auto endTime = Clock::now();
+  return chrono::duration_cast<chrono::microseconds>(endTime - startTime).count();
+}
+
+/**
+ * An engine compiled with a table implementation
+ */
+struct Engine {
+  string name;
+  string table;
+  // bytes of a cell in the table
+  long bytesPerCell;
+  double (*run)(long, long, int, int, const vector<int>&, double&, PerfCounters*);
+};
+
+const vector<Engine> ENGINES = {
+  {"threads1D", "ints", sizeof(int), timeRun<Life<threads1D_ints::Game>>},
+  {"threads1D", "cells", sizeof(threads1D_cells::Cell), timeRun<Life<threads1D_cells::Game>>},
+  {"threads2D", "ints", sizeof(int), timeRun<Life<threads2D_ints::Game>>},
+  {"threads2D", "cells", sizeof(threads2D_cells::Cell), timeRun<Life<threads2D_cells::Game>>},
+  {"active1D", "ints", sizeof(int), timeRun<Life<active1D_ints::Game>>},
+  {"active1D", "cells", sizeof(active1D_cells::Cell), timeRun<Life<active1D_cells::Game>>},
+  {"ref1D", "ints", sizeof(int), timeRun<LifeRef<ref1D_ints::Game>>},
+  {"refActive1D", "ints", sizeof(int), timeRun<LifeRef<refActive1D_ints::Game>>},
+#ifdef FF
+  {"ff1D", "ints", sizeof(int), timeRun<Life<ff1D_ints::Game>>},
+  {"ffDM2D", "ints", sizeof(int), timeRun<Life<ffDM2D_ints::Game>>},
+#endif
+};
+
+/**
+ * Result of a run of a configuration
+ */
+struct Result {
+  string engine;
+  string table;
+  long height;
+  long width;
+  int nw;
+  int steps;
+  string workload;
+  // fraction of live cells in the input
+  double density;
+  int run;
+  double time;
+  double overhead;
+  // cells updated per second
+  double throughput;
+  // events counted by all the workers and by each one, NAN if not available
+  vector<double> counts;
+  vector<vector<double>> workerCounts;
+  // position on the roofline, if computed
+  bool placed;
+  RooflinePoint point;
+};
+
+// names of the counted events
+const vector<PerfEvent> EVENTS = defaultPerfEvents();
+
+/**
+ * Splits a comma separated list
+ */
+vector<string> split(const string& list) {
+  vector<string> items;
+  stringstream ss(list);
+  string item;
+  while (getline(ss, item, ',')) {
+    if (!item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+/**
+ * @returns true if the list contains the item, or the list is "all"
+ */
+bool selected(const vector<string>& list, const string& item) {
+  for (auto& l : list) {
+    if (l == item || l == "all") return true;
+  }
+  return false;
+}
+
+/**
+ * Writes a counted value, empty in CSV or null in JSON if not available
+ */
+void writeCount(ostream& out, double value, bool json) {
+  if (std::isnan(value)) out << (json ? "null" : "");
+  else out << (long long) value;
+}
+
+void writeCSV(ostream& out, const vector<Result>& results, bool counting, bool roofline) {
+  out << "engine,table,height,width,nw,steps,workload,density,run,time_us,overhead_us,cells_per_s";
+  if (counting) {
+    for (auto& e : EVENTS) out << "," << e.name;
+  }
+  if (roofline) out << ",bytes_per_s,attainable_cells_per_s,roofline_fraction,bound";
+  out << endl;
+  for (auto& r : results) {
+    out << r.engine << "," << r.table << "," << r.height << "," << r.width << "," << r.nw << ","
+        << r.steps << "," << r.workload << "," << r.density << "," << r.run << "," << r.time << "," << r.overhead << ","
+        << (long long) r.throughput;
+    for (double c : r.counts) {
+      out << ",";
+      writeCount(out, c, false);
+    }
+    if (r.placed) {
+      out << "," << (long long) r.point.bytesPerSecond << "," << (long long) r.point.attainable << ","
+          << r.point.fraction << "," << (r.point.memoryBound ? "memory" : "compute");
+    }
+    out << endl;
+  }
+}
+
+void writeJSON(ostream& out, const vector<Result>& results) {
+  out << "[" << endl;
+  for (size_t i = 0; i < results.size(); i++) {
+    auto& r = results[i];
+    out << "  {\"engine\": \"" << r.engine << "\", \"table\": \"" << r.table << "\", \"height\": " << r.height
+        << ", \"width\": " << r.width << ", \"nw\": " << r.nw << ", \"steps\": " << r.steps
+        << ", \"workload\": \"" << r.workload << "\", \"density\": " << r.density << ", \"run\": " << r.run << ", \"time_us\": " << r.time
+        << ", \"overhead_us\": " << r.overhead << ", \"cells_per_s\": "
+        << (long long) r.throughput;
+    if (!r.counts.empty()) {
+      out << ", \"counters\": {";
+      for (size_t e = 0; e < EVENTS.size(); e++) {
+        out << (e > 0 ? ", \"" : "\"") << EVENTS[e].name << "\": ";
+        writeCount(out, r.counts[e], true);
+      }
+      out << ", \"workers\": [";
+      for (size_t w = 0; w < r.workerCounts.size(); w++) {
+        out << (w > 0 ? ", {" : "{");
+        for (size_t e = 0; e < EVENTS.size(); e++) {
+          out << (e > 0 ? ", \"" : "\"") << EVENTS[e].name << "\": ";
+          writeCount(out, r.workerCounts[w][e], true);
+        }
+        out << "}";
+      }
+      out << "]}";
+    }
+    if (r.placed) {
+      out << ", \"bytes_per_s\": " << (long long) r.point.bytesPerSecond << ", \"attainable_cells_per_s\": "
+          << (long long) r.point.attainable << ", \"roofline_fraction\": " << r.point.fraction
+          << ", \"bound\": \"" << (r.point.memoryBound ? "memory" : "compute") << "\"";
+    }
+    out << "}" << (i + 1 < results.size() ? "," : "") << endl;
+  }
+  out << "]" << endl;
+}
+
+/**
+ * @returns the configuration of a result, as stored in the results database
+ */
+string configuration(const Result& r, uint64_t seed) {
+  stringstream ss;
+  ss << r.engine << "/" << r.table << "/" << r.workload << "/" << r.height << "x" << r.width << "/nw" << r.nw
+     << "/steps" << r.steps << "/seed" << seed;
+  return ss.str();
+}
+
+/**
+ * Writes the comparison against the baseline
+ *
+ * @returns the number of regressions
+ */
+int writeComparison(ostream& out, const vector<Comparison>& comparisons) {
+  int regressions = 0;
+  out << "configuration,baseline_runs,current_runs,baseline_median_us,current_median_us,ratio,ratio_low,ratio_high,"
+      << "verdict" << endl;
+  for (auto& c : comparisons) {
+    string verdict = !c.comparable ? "insufficient" : c.regression ? "regression"
+                     : c.improvement ? "improvement" : "unchanged";
+    regressions += c.regression;
+    out << c.configuration << "," << c.baselineRuns << "," << c.currentRuns << "," << c.baselineMedian << ","
+        << c.currentMedian << "," << c.ratio.estimate << "," << c.ratio.low << "," << c.ratio.high << ","
+        << verdict << endl;
+  }
+  return regressions;
+}
+
+void usage(const char* name) {
+  cout << "Usage is " << name << " [options], each option taking a comma separated list" << endl;
+  cout << "  --engines   engines to run, or all (default all):";
+  string last;
+  for (auto& e : ENGINES) {
+    if (e.name != last) cout << " " << e.name;
+    last = e.name;
+  }
+  cout << endl;
+  cout << "  --tables    ints, cells or all (default all)" << endl;
+  cout << "  --sizes     grid sizes as HEIGHTxWIDTH or SIDE (default 512)" << endl;
+  cout << "  --nw        numbers of workers (default 1,2,4)" << endl;
+  cout << "  --steps     numbers of steps (default 100)" << endl;
+  cout << "  --workloads inputs from the corpus (default soup50):";
+  for (auto& w : workloadNames()) cout << " " << w;
+  cout << endl;
+  cout << "  --density   probabilities of a cell being alive, added as soup workloads" << endl;
+  cout << "  --runs      repetitions of each configuration (default 3)" << endl;
+  cout << "  --seed      seed of the inputs (default 112233)" << endl;
+  cout << "  --format    csv or json (default csv)" << endl;
+  cout << "  --out       output file (default standard output)" << endl;
+  cout << "  --counters  on to count the hardware events of the workers (default off)" << endl;
+  cout << "  --roofline  on to place each run on the roofline of the machine, measured at startup (default off)" << endl;
+  cout << "  --db        directory of the results database (default bench_results)" << endl;
+  cout << "  --save      on to save the runs in the results database (default off)" << endl;
+  cout << "  --revision  revision under which the runs are saved (default the git revision)" << endl;
+  cout << "  --baseline  revision whose stored runs on this host are compared with the current ones" << endl;
+  cout << "  --tolerance relative slowdown not flagged as a regression (default 0.05)" << endl;
+  cout << "  --stored    revision whose stored runs are compared instead of executing the runs" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  vector<string> engines = {"all"};
+  vector<string> tables = {"all"};
+  vector<string> sizes = {"512"};
+  vector<string> workers = {"1", "2", "4"};
+  vector<string> steps = {"100"};
+  vector<string> workloads;
+  int nRuns = 3;
+  uint64_t seed = 112233;
+  string format = "csv";
+  string outPath;
+  bool counting = false;
+  bool roofline = false;
+  string dbPath = "bench_results";
+  bool saving = false;
+  string revision;
+  string baseline;
+  double tolerance = 0.05;
+  string stored;
+
+  // args
+  for (int i = 1; i < argc; i++) {
+    string option = argv[i];
+    if (option == "--help" || i + 1 == argc) {
+      usage(argv[0]);
+      return option == "--help" ? 0 : -1;
+    }
+    string value = argv[++i];
+    if (option == "--engines") engines = split(value);
+    else if (option == "--tables") tables = split(value);
+    else if (option == "--sizes") sizes = split(value);
+    else if (option == "--nw") workers = split(value);
+    else if (option == "--steps") steps = split(value);
+    else if (option == "--workloads") {
+      for (auto& w : split(value)) workloads.push_back(w);
+    }
+    else if (option == "--density") {
+      // a soup named by the percentage of live cells
+      for (auto& d : split(value)) {
+        stringstream name;
+        name << "soup" << atof(d.c_str()) * 100;
+        workloads.push_back(name.str());
+      }
+    }
+    else if (option == "--runs") nRuns = atoi(value.c_str());
+    else if (option == "--seed") seed = strtoull(value.c_str(), nullptr, 10);
+    else if (option == "--format") format = value;
+    else if (option == "--out") outPath = value;
+    else if (option == "--counters") counting = value == "on";
+    else if (option == "--roofline") roofline = value == "on";
+    else if (option == "--db") dbPath = value;
+    else if (option == "--save") saving = value == "on";
+    else if (option == "--revision") revision = value;
+    else if (option == "--baseline") baseline = value;
+    else if (option == "--tolerance") tolerance = atof(value.c_str());
+    else if (option == "--stored") stored = value;
+    else {
+      cout << "Unknown option " << option << endl;
+      usage(argv[0]);
+      return -1;
+    }
+  }
+  if (nRuns <= 0 || (format != "csv" && format != "json") || tolerance < 0
+      || (!stored.empty() && (baseline.empty() || saving))) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  if (workloads.empty()) workloads = {"soup50"};
+
+  ResultsDatabase db(dbPath);
+  string host = hostFingerprint();
+  if (revision.empty()) revision = gitRevision();
+  if (!stored.empty()) {
+    // compares two stored revisions, without executing any run
+    ofstream file;
+    if (!outPath.empty()) file.open(outPath);
+    ostream& out = outPath.empty() ? cout : file;
+    try {
+      vector<Comparison> comparisons = compareRuns(db.load(host, baseline), db.load(host, stored), tolerance);
+      return writeComparison(out, comparisons) > 0 ? 1 : 0;
+    } catch (const char* msg) {
+      cerr << host << ": " << msg << endl;
+      return -1;
+    }
+  }
+
+  MachineRoof roof = MachineRoof();
+  if (roofline) {
+    // bandwidth measured with as many threads as the largest run
+    int threads = 1;
+    for (auto& w : workers) threads = max(threads, atoi(w.c_str()));
+    roof = calibrateRoof(threads);
+    cerr << "Memory bandwidth (" << threads << " threads): " << roof.bandwidth / 1e9 << " GB/s" << endl;
+    cerr << "Compute peak of a core: " << roof.cellPeak / 1e6 << " Mcells/s" << endl;
+  }
+
+  vector<Result> results;
+  for (auto& size : sizes) {
+    size_t x = size.find('x');
+    long height = atol(size.substr(0, x).c_str());
+    long width = x == string::npos ? height : atol(size.substr(x + 1).c_str());
+    for (auto& name : workloads) {
+      // the same input for every engine
+      vector<int> input;
+      try {
+        input = workload(name, height, width, seed);
+      } catch (const char* msg) {
+        cerr << name << " " << height << "x" << width << ": " << msg << endl;
+        continue;
+      }
+      long alive = 0;
+      for (int cell : input) alive += cell != 0;
+      double density = (double) alive / (height * width);
+      for (auto& e : ENGINES) {
+        if (!selected(engines, e.name) || !selected(tables, e.table)) continue;
+        for (auto& s : steps) {
+          for (auto& w : workers) {
+            int nSteps = atoi(s.c_str());
+            int nw = atoi(w.c_str());
+            for (int run = 0; run < nRuns; run++) {
+              try {
+                double overhead = 0;
+                unique_ptr<PerfCounters> counters(counting ? new PerfCounters(nw) : nullptr);
+                double time = e.run(height, width, nw, nSteps, input, overhead, counters.get());
+                double throughput = time > 0 ? height * width * (double) nSteps / (time * 1e-6) : 0;
+                results.push_back({e.name, e.table, height, width, nw, nSteps, name, density, run, time, overhead, throughput,
+                                   {}, {}, roofline, {}});
+                if (roofline) results.back().point = rooflinePoint(roof, throughput, e.bytesPerCell, nw);
+                if (counting) {
+                  Result& r = results.back();
+                  r.workerCounts = vector<vector<double>>(nw, vector<double>(EVENTS.size(), NAN));
+                  for (size_t k = 0; k < EVENTS.size(); k++) {
+                    bool available = counters->isAvailable(k);
+                    r.counts.push_back(available ? counters->total(k) : NAN);
+                    for (int i = 0; i < nw && available; i++) r.workerCounts[i][k] = counters->get(i, k);
+                  }
+                }
+                cerr << e.name << "/" << e.table << " " << height << "x" << width << " nw=" << nw
+                     << " steps=" << nSteps << " " << name << ": " << time << " us" << endl;
+              } catch (const char* msg) {
+                cerr << e.name << "/" << e.table << " " << height << "x" << width << " nw=" << nw
+                     << ": " << msg << endl;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  ofstream file;
+  if (!outPath.empty()) {
+    file.open(outPath);
+    if (!file) {
+      cerr << "Cannot open " << outPath << endl;
+      return -1;
+    }
+  }
+  ostream& out = outPath.empty() ? cout : file;
+  if (format == "csv") writeCSV(out, results, counting, roofline);
+  else writeJSON(out, results);
+
+  vector<RunRecord> runs;
+  for (auto& r : results) runs.push_back({configuration(r, seed), r.time});
+  try {
+    if (saving) {
+      db.save(host, revision, runs);
+      cerr << "Saved " << runs.size() << " runs as " << host << "/" << revision << endl;
+    }
+    if (!baseline.empty()) {
+      cerr << "Comparison against " << baseline << ":" << endl;
+      return writeComparison(cerr, compareRuns(db.load(host, baseline), runs, tolerance)) > 0 ? 1 : 0;
+    }
+  } catch (const char* msg) {
+    cerr << host << ": " << msg << endl;
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * Engines of the framework compiled side by side for the benchmarks, each one in
+ * its own namespace, the CELLS macro selecting the table implementation, and the
+ * Game of life rule they are benchmarked with.
+ *
+ * The FastFlow engines are compiled only if FF is defined. The headers shared by
+ * the engines are guarded, and are included once before the namespaces.
+ */
+#ifndef BENCH_ENGINES_HPP
+#define BENCH_ENGINES_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <memory>
+#include <cstdlib>
+#include <chrono>
+
+// headers shared by the engines, included once for all of them
+#include "random.hpp"
+#include "view.hpp"
+#include "balance.hpp"
+#include "run_control.hpp"
+#include "byte_order.hpp"
+#include "snapshot.hpp"
+#include "stream.hpp"
+#include "video.hpp"
+#include "shm_ring.hpp"
+#include "delta.hpp"
+#include "loaders.hpp"
+#include "reductions.hpp"
+#include "cycles.hpp"
+#include "pyramid.hpp"
+#include "changes.hpp"
+#include "render.hpp"
+#include "trace.hpp"
+#include "perf_counters.hpp"
+#include "roofline.hpp"
+#include "metrics.hpp"
+
+#ifdef FF
+#include <ff/ff.hpp>
+#include <ff/farm.hpp>
+#endif
+
+namespace threads1D_ints {
+#include "frame_threads_1D.hpp"
+}
+namespace threads1D_cells {
+#define CELLS
+#include "frame_threads_1D.hpp"
+#undef CELLS
+}
+namespace threads2D_ints {
+#include "frame_threads_2D.hpp"
+}
+namespace threads2D_cells {
+#define CELLS
+#include "frame_threads_2D.hpp"
+#undef CELLS
+}
+namespace active1D_ints {
+#include "framework2.0/frame_threads_1D_active.hpp"
+}
+namespace active1D_cells {
+#define CELLS
+#include "framework2.0/frame_threads_1D_active.hpp"
+#undef CELLS
+}
+namespace ref1D_ints {
+#include "framework2.0/frame_threads_1D_ref.hpp"
+}
+namespace refActive1D_ints {
+#include "framework2.0/frame_threads_1D_ref_active.hpp"
+}
+#ifdef FF
+namespace ff1D_ints {
+#include "frameFF_mw_1D.hpp"
+}
+namespace ffDM2D_ints {
+#include "frameFF_DM2D.hpp"
+}
+#endif
+
+using namespace std;
+typedef std::chrono::high_resolution_clock Clock;
+
+/**
+ * Game of life on the engines whose rule receives the neighbourhood by value
+ */
+template<class G>
+class Life: public G {
+  public:
+    Life(int height, int width, int nw, const vector<int>& input)
+      : G(height, width, nw, input) {}
+
+    int rule(int value, vector<int> neighValues) {
+      int sum = 0;
+      for (int i = 0; i < 8; i++) {
+        sum += neighValues[i];
+      }
+      if (sum == 3 || (sum == 2 && value == 1)) return 1;
+      return 0;
+    }
+};
+
+/**
+ * Game of life on the engines whose rule receives the neighbourhood by pointer
+ */
+template<class G>
+class LifeRef: public G {
+  public:
+    LifeRef(int height, int width, int nw, const vector<int>& input)
+      : G(height, width, nw, input) {}
+
+    int rule(int value, vector<int>* neighValues) {
+      int sum = 0;
+      for (int i = 0; i < 8; i++) {
+        sum += (*neighValues)[i];
+      }
+      if (sum == 3 || (sum == 2 && value == 1)) return 1;
+      return 0;
+    }
+};
+
+#endif
@@ -0,0 +1,201 @@
+/**
+ * Microbenchmark of the per-generation synchronization of the engines, isolated
+ * from the computation.
+ *
+ * Each engine runs a tiny grid of dead cells, one row per worker, so that the
+ * duration of a step is dominated by the generation barrier. For every number
+ * of workers, including more workers than cores (oversubscription), the steps
+ * are timed in batches, each on a new Game, giving the distribution of the
+ * latency of a step. The engines able to trace their runs (see trace.hpp) also
+ * report the distribution of the barrier round-trip of each generation: from the
+ * arrival of the last worker to the release of the last worker.
+ *
+ * Compile from the root of the repository with
+ *   g++ -std=c++14 -O3 -pthread -I. bench_sync.cpp -o bench_sync
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+
+#include "bench_engines.hpp"
+#include "sampling.hpp"
+
+/**
+ * Attaches the tracer to the engines able to trace their runs
+ *
+ * @returns true if the engine traces its runs
+ */
+template<class T>
+auto attachTracer(T& game, Tracer* tracer, int) -> decltype(game.setTracer(tracer), bool()) {
+  game.setTracer(tracer);
+  return true;
+}
+template<class T>
+bool attachTracer(T&, Tracer*, long) { return false; }
+
+/**
+ * Runs batches of steps of an engine on a grid with one row of dead cells per worker
+ *
+ * @param steps steps of each batch
+ * @param stepTimes receives the mean duration of a step of each batch, in us
+ * @param roundTrips receives the barrier round-trip of each traced generation, in us
+ */
+template<class T>
+void timeSync(int nw, long width, int steps, int batches, vector<double>& stepTimes, vector<double>& roundTrips) {
+  vector<int> input(nw * width, 0);
+  for (int b = 0; b < batches; b++) {
+    T game(nw, width, nw, input);
+    Tracer tracer(nw, 2 * steps);
+    bool traced = attachTracer(game, &tracer, 0);
+    auto startTime = Clock::now();
+    game.run(steps);
+    auto endTime = Clock::now();
+    stepTimes.push_back(chrono::duration_cast<chrono::nanoseconds>(endTime - startTime).count() / 1000.0 / steps);
+    if (!traced) continue;
+    // latest arrival and release of each generation
+    vector<int64_t> arrivals(steps + 1, INT64_MIN);
+    vector<int64_t> releases(steps + 1, INT64_MIN);
+    long first = -1;
+    for (int i = 0; i < nw; i++) {
+      for (auto& r : tracer.getRecords(i)) {
+        if (r.kind != TRACE_BARRIER) continue;
+        if (first < 0) first = r.generation;
+        long g = r.generation - first;
+        if (g < 0 || g > steps) continue;
+        arrivals[g] = max(arrivals[g], r.start);
+        releases[g] = max(releases[g], r.end);
+      }
+    }
+    for (int g = 0; g <= steps; g++) {
+      if (arrivals[g] != INT64_MIN) roundTrips.push_back((releases[g] - arrivals[g]) / 1000.0);
+    }
+  }
+}
+
+/**
+ * An engine whose synchronization is measured
+ */
+struct SyncEngine {
+  string name;
+  void (*run)(int, long, int, int, vector<double>&, vector<double>&);
+};
+
+const vector<SyncEngine> ENGINES = {
+  {"threads1D", timeSync<Life<threads1D_ints::Game>>},
+  {"threads2D", timeSync<Life<threads2D_ints::Game>>},
+  {"active1D", timeSync<Life<active1D_ints::Game>>},
+  {"ref1D", timeSync<LifeRef<ref1D_ints::Game>>},
+  {"refActive1D", timeSync<LifeRef<refActive1D_ints::Game>>},
+#ifdef FF
+  {"ff1D", timeSync<Life<ff1D_ints::Game>>},
+  {"ffDM2D", timeSync<Life<ffDM2D_ints::Game>>},
+#endif
+};
+
+/**
+ * Splits a comma separated list
+ */
+vector<string> split(const string& list) {
+  vector<string> items;
+  stringstream ss(list);
+  string item;
+  while (getline(ss, item, ',')) {
+    if (!item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+void usage(const char* name) {
+  cout << "Usage is " << name << " [options], lists being comma separated" << endl;
+  cout << "  --engines   engines to run, or all (default all):";
+  for (auto& e : ENGINES) cout << " " << e.name;
+  cout << endl;
+  cout << "  --nw        numbers of workers (default 2 and 1, 2, 4 times the cores)" << endl;
+  cout << "  --width     cells of the row of each worker (default 8)" << endl;
+  cout << "  --steps     steps of each batch (default 100)" << endl;
+  cout << "  --batches   batches of each configuration (default 10)" << endl;
+  cout << "  --out       CSV output file (default standard output)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  int cores = max(1u, thread::hardware_concurrency());
+  vector<string> engines = {"all"};
+  vector<int> workers;
+  for (int nw : {2, cores, 2 * cores, 4 * cores}) {
+    if (nw >= 2 && find(workers.begin(), workers.end(), nw) == workers.end()) workers.push_back(nw);
+  }
+  long width = 8;
+  int steps = 100;
+  int batches = 10;
+  string outPath;
+
+  // args
+  for (int i = 1; i < argc; i++) {
+    string option = argv[i];
+    if (option == "--help" || i + 1 == argc) {
+      usage(argv[0]);
+      return option == "--help" ? 0 : -1;
+    }
+    string value = argv[++i];
+    if (option == "--engines") engines = split(value);
+    else if (option == "--nw") {
+      workers.clear();
+      for (auto& w : split(value)) workers.push_back(atoi(w.c_str()));
+    }
+    else if (option == "--width") width = atol(value.c_str());
+    else if (option == "--steps") steps = atoi(value.c_str());
+    else if (option == "--batches") batches = atoi(value.c_str());
+    else if (option == "--out") outPath = value;
+    else {
+      cout << "Unknown option " << option << endl;
+      usage(argv[0]);
+      return -1;
+    }
+  }
+  if (width <= 0 || steps <= 0 || batches <= 0) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  ofstream file;
+  if (!outPath.empty()) {
+    file.open(outPath);
+    if (!file) {
+      cerr << "Cannot open " << outPath << endl;
+      return -1;
+    }
+  }
+  ostream& out = outPath.empty() ? cout : file;
+  out << "engine,nw,cores,oversubscription,steps,batches,step_median_us,step_p5_us,step_p95_us,step_max_us,"
+      << "round_trip_median_us,round_trip_p95_us,round_trip_p99_us,round_trip_max_us,round_trip_outliers" << endl;
+  for (auto& e : ENGINES) {
+    if (find(engines.begin(), engines.end(), e.name) == engines.end()
+        && find(engines.begin(), engines.end(), "all") == engines.end()) continue;
+    for (int nw : workers) {
+      vector<double> stepTimes;
+      vector<double> roundTrips;
+      try {
+        e.run(nw, width, steps, batches, stepTimes, roundTrips);
+      } catch (const char* msg) {
+        cerr << e.name << " nw=" << nw << ": " << msg << endl;
+        continue;
+      }
+      Summary s = summarize(stepTimes);
+      out << e.name << "," << nw << "," << cores << "," << (double) nw / cores << "," << steps << "," << batches << ","
+          << s.median << "," << s.p5 << "," << s.p95 << "," << s.max << ",";
+      if (!roundTrips.empty()) {
+        Summary r = summarize(roundTrips);
+        sort(roundTrips.begin(), roundTrips.end());
+        out << r.median << "," << r.p95 << "," << percentile(roundTrips, 99) << "," << r.max << "," << r.outliers;
+      }
+      else out << ",,,,";
+      out << endl;
+      cerr << e.name << " nw=" << nw << ": " << s.median << " us per step" << endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,250 @@
+/**
+ * Microbenchmark of the primitives of the table implementations, single-threaded.
+ *
+ * For each table (ints_1D_t.hpp, ints_2D_t.hpp, cells_1D_t.hpp, cells_2D_t.hpp,
+ * framework2.0/ints_1D_t_ref.hpp) and each grid size, from tables fitting in the
+ * L1 cache to tables only fitting in memory, it measures the nanoseconds per
+ * cell of getCellValue, getNeighbours, getNeighboursRef (where available) and
+ * setFuture over the whole grid, the nanoseconds per call of swapCurrentFuture
+ * (also amortized over the cells of the grid), and the nanoseconds per cell of a
+ * full sweep computing the Game of life. Every measure is repeated and reported
+ * by its median and minimum. The ns_per_sample_unit column reports the median
+ * time of the unit of the samples: a pass over the grid for the per-cell
+ * primitives, a single call for swapCurrentFuture.
+ *
+ * Compile from the root of the repository with
+ *   g++ -std=c++14 -O3 -pthread -I. bench_table.cpp -o bench_table
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "bench_engines.hpp"
+#include "sampling.hpp"
+
+// prevents the measured loops from being optimized away
+volatile long sink;
+
+/**
+ * Measures of a primitive on a grid
+ */
+struct PrimitiveResult {
+  string primitive;
+  // samples of the nanoseconds per unit: a pass over the grid, or a single call
+  // of swapCurrentFuture
+  vector<double> samples;
+  // cells over which a unit is amortized
+  long cells;
+};
+
+/**
+ * Times passes of a loop over the cells
+ *
+ * @param passes passes in each sample
+ * @param pass function performing a pass and returning a value depending on it
+ * @returns the nanoseconds per pass of each sample
+ */
+template<class F>
+vector<double> timePasses(int samples, long passes, F pass) {
+  vector<double> times;
+  long result = pass();
+  for (int s = 0; s < samples; s++) {
+    auto startTime = Clock::now();
+    for (long p = 0; p < passes; p++) {
+      result += pass();
+    }
+    auto endTime = Clock::now();
+    times.push_back(chrono::duration_cast<chrono::nanoseconds>(endTime - startTime).count() / (double) passes);
+  }
+  sink = result;
+  return times;
+}
+
+/**
+ * Measures getNeighboursRef on the tables offering it
+ */
+template<class T>
+auto timeNeighboursRef(T& table, long size, int samples, long passes, vector<PrimitiveResult>& results, int)
+    -> decltype(table.getNeighboursRef(0, (vector<int>*) nullptr), void()) {
+  vector<int> neighbours(8);
+  results.push_back({"getNeighboursRef", timePasses(samples, passes, [&]() {
+    long sum = 0;
+    for (long i = 0; i < size; i++) {
+      table.getNeighboursRef(i, &neighbours);
+      sum += neighbours[0];
+    }
+    return sum;
+  }), size});
+}
+template<class T>
+void timeNeighboursRef(T&, long, int, long, vector<PrimitiveResult>&, long) {}
+
+/**
+ * Measures the primitives of a table implementation on a grid
+ *
+ * @param samples samples of each primitive
+ * @param passes passes over the grid in each sample
+ */
+template<class T>
+vector<PrimitiveResult> timeTable(long height, long width, int samples, long passes, uint64_t seed) {
+  long size = height * width;
+  vector<int> input(size);
+  uint64_t threshold = densityThreshold(0.5);
+  for (long i = 0; i < size; i++) {
+    input[i] = randomCell(seed, threshold, i);
+  }
+  T table(height, width, input);
+  vector<PrimitiveResult> results;
+  results.push_back({"getCellValue", timePasses(samples, passes, [&]() {
+    long sum = 0;
+    for (long i = 0; i < size; i++) {
+      sum += table.getCellValue(i);
+    }
+    return sum;
+  }), size});
+  results.push_back({"getNeighbours", timePasses(samples, passes, [&]() {
+    long sum = 0;
+    for (long i = 0; i < size; i++) {
+      sum += table.getNeighbours(i)[0];
+    }
+    return sum;
+  }), size});
+  timeNeighboursRef(table, size, samples, passes, results, 0);
+  results.push_back({"setFuture", timePasses(samples, passes, [&]() {
+    for (long i = 0; i < size; i++) {
+      table.setFuture(i, i & 1);
+    }
+    return 0L;
+  }), size});
+  results.push_back({"swapCurrentFuture", timePasses(samples, passes * size, [&]() {
+    table.swapCurrentFuture();
+    return 0L;
+  }), size});
+  results.push_back({"sweep", timePasses(samples, passes, [&]() {
+    for (long i = 0; i < size; i++) {
+      vector<int> neighbours = table.getNeighbours(i);
+      int sum = 0;
+      for (int k = 0; k < 8; k++) {
+        sum += neighbours[k];
+      }
+      table.setFuture(i, sum == 3 || (sum == 2 && table.getCellValue(i) == 1));
+    }
+    table.swapCurrentFuture();
+    return (long) table.getCellValue(0);
+  }), size});
+  return results;
+}
+
+/**
+ * A table implementation
+ */
+struct TableImpl {
+  string name;
+  // bytes of a cell
+  long bytesPerCell;
+  vector<PrimitiveResult> (*run)(long, long, int, long, uint64_t);
+};
+
+// each table is measured as compiled in the namespace of an engine employing it
+const vector<TableImpl> TABLES = {
+  {"ints_1D", sizeof(int), timeTable<threads1D_ints::Table>},
+  {"ints_2D", sizeof(int), timeTable<threads2D_ints::Table>},
+  {"cells_1D", sizeof(threads1D_cells::Cell), timeTable<threads1D_cells::Table>},
+  {"cells_2D", sizeof(threads2D_cells::Cell), timeTable<threads2D_cells::Table>},
+  {"ints_1D_ref", sizeof(int), timeTable<ref1D_ints::Table>},
+};
+
+/**
+ * Splits a comma separated list
+ */
+vector<string> split(const string& list) {
+  vector<string> items;
+  stringstream ss(list);
+  string item;
+  while (getline(ss, item, ',')) {
+    if (!item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+void usage(const char* name) {
+  cout << "Usage is " << name << " [options], lists being comma separated" << endl;
+  cout << "  --tables    tables to measure, or all (default all):";
+  for (auto& t : TABLES) cout << " " << t.name;
+  cout << endl;
+  cout << "  --sizes     grid sizes as HEIGHTxWIDTH or SIDE (default 32,128,512,2048)" << endl;
+  cout << "  --samples   samples of each primitive (default 5)" << endl;
+  cout << "  --cells     minimum cells visited by a sample (default 4194304)" << endl;
+  cout << "  --seed      seed of the cells (default 112233)" << endl;
+  cout << "  --out       CSV output file (default standard output)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  vector<string> tables = {"all"};
+  vector<string> sizes = {"32", "128", "512", "2048"};
+  int samples = 5;
+  long minCells = 1 << 22;
+  uint64_t seed = 112233;
+  string outPath;
+
+  // args
+  for (int i = 1; i < argc; i++) {
+    string option = argv[i];
+    if (option == "--help" || i + 1 == argc) {
+      usage(argv[0]);
+      return option == "--help" ? 0 : -1;
+    }
+    string value = argv[++i];
+    if (option == "--tables") tables = split(value);
+    else if (option == "--sizes") sizes = split(value);
+    else if (option == "--samples") samples = atoi(value.c_str());
+    else if (option == "--cells") minCells = atol(value.c_str());
+    else if (option == "--seed") seed = strtoull(value.c_str(), nullptr, 10);
+    else if (option == "--out") outPath = value;
+    else {
+      cout << "Unknown option " << option << endl;
+      usage(argv[0]);
+      return -1;
+    }
+  }
+  if (samples <= 0 || minCells <= 0) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  ofstream file;
+  if (!outPath.empty()) {
+    file.open(outPath);
+    if (!file) {
+      cerr << "Cannot open " << outPath << endl;
+      return -1;
+    }
+  }
+  ostream& out = outPath.empty() ? cout : file;
+  out << "table,primitive,height,width,table_bytes,ns_per_sample_unit,ns_per_cell_median,ns_per_cell_min" << endl;
+  for (auto& size : sizes) {
+    size_t x = size.find('x');
+    long height = atol(size.substr(0, x).c_str());
+    long width = x == string::npos ? height : atol(size.substr(x + 1).c_str());
+    if (height <= 0 || width <= 0) {
+      cerr << "Invalid size " << size << endl;
+      continue;
+    }
+    long passes = max(1L, minCells / (height * width));
+    for (auto& t : TABLES) {
+      if (find(tables.begin(), tables.end(), t.name) == tables.end()
+          && find(tables.begin(), tables.end(), "all") == tables.end()) continue;
+      for (auto& r : t.run(height, width, samples, passes, seed)) {
+        Summary s = summarize(r.samples);
+        out << t.name << "," << r.primitive << "," << height << "," << width << ","
+            << 2 * height * width * t.bytesPerCell << "," << s.median << ","
+            << s.median / r.cells << "," << s.min / r.cells << endl;
+      }
+      cerr << t.name << " " << height << "x" << width << " done" << endl;
+    }
+  }
+  return 0;
+}
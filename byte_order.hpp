@@ -0,0 +1,55 @@
+/**
+ * Byte order of the binary formats of the framework (snapshots, delta
+ * recordings and packed grids): every integer is serialized as little endian,
+ * whatever the byte order of the host.
+ */
+#ifndef BYTE_ORDER_HPP
+#define BYTE_ORDER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @returns true if the host stores integers in little endian order, in which
+ * case the serialized integers can be used in place
+ */
+inline bool hostIsLittleEndian() {
+  const uint32_t one = 1;
+  uint8_t first;
+  memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+/**
+ * Stores the lowest bytes of an unsigned integer at p, in little endian order
+ */
+inline void storeLittleEndian(uint8_t* p, uint64_t v, int bytes) {
+  for (int b = 0; b < bytes; b++) {
+    p[b] = (uint8_t) (v >> (8 * b));
+  }
+}
+
+/**
+ * Appends the lowest bytes of an unsigned integer, in little endian order
+ */
+inline void putLittleEndian(vector<uint8_t>& out, uint64_t v, int bytes) {
+  for (int b = 0; b < bytes; b++) {
+    out.push_back((uint8_t) (v >> (8 * b)));
+  }
+}
+
+/**
+ * Reads an unsigned integer written by storeLittleEndian or putLittleEndian
+ */
+inline uint64_t getLittleEndian(const uint8_t* p, int bytes) {
+  uint64_t v = 0;
+  for (int b = 0; b < bytes; b++) {
+    v |= (uint64_t) p[b] << (8 * b);
+  }
+  return v;
+}
+
+#endif
@@ -1,7 +1,11 @@
 #include <iostream>
 #include <cstdlib>
+#include <string>
 #include <vector>
 
+#include "random.hpp"
+#include "view.hpp"
+
 using namespace std;
 
 /**
@@ -11,8 +15,8 @@ using namespace std;
  * @param b right-handside of the modulo operation
  * @returns the modulo operation from a and b
  */
-int mod(int a, int b) {
-  int r = a - (int) (a / b) * b;
+long mod(long a, long b) {
+  long r = a - (a / b) * b;
   return r < 0 ? (r + b) : r;
 }
 
@@ -24,7 +28,7 @@ int mod(int a, int b) {
  */
 class Cell {
   private: 
-    int index;
+    long index;
     int row;
     int column;
     int value;
@@ -34,18 +38,20 @@ class Cell {
     Cell() = default;
 
     // Constructor
-    Cell(int index, int value, int row, int column): 
+    Cell(long index, int value, int row, int column): 
       index(index), value(value), row(row), column(column) {}
 
     // Constructor without value
-    Cell(int index, int row, int column):
+    Cell(long index, int row, int column):
       index(index), row(row), column(column) {}
 
     // Getters
-    int getIndex() { return index; }
+    long getIndex() { return index; }
     int getValue() { return value; }
     int getRow() { return row; }
     int getColumn() { return column; }
+    // address of the value, read by the views of the table
+    const int* getValueAddress() { return &value; }
 
     // Setter
     void setValue(int v) { value = v; }
@@ -60,84 +66,137 @@ class Table {
   private:
     Cell* current;
     Cell* future;
-    int width;
-    int height;
+    long width;
+    long height;
 
   public:
     // Default constructor
     Table() {}
 
-    // Constructor initializing the table with random values
+    // Constructor, the cells must then be initialized with generate()
     Table(int height, int width):
       height(height), width(width) {
-      int size = height * width;
-      int column, row;
+      long size = (long) height * width;
+      current = new Cell[size];
+      future = new Cell[size];
+    }
+
+    // Constructor initializing the table with input values
+    Table(int height, int width, const vector<int>& input):
+      height(height), width(width) {
+      long size = (long) height * width;
+      long column, row;
       current = new Cell[size];
       future = new Cell[size];
-      for (int i = 0; i < size; i++) {
+      for (long i = 0; i < size; i++) {
         row = i / width;
         column = i % width;
-        current[i] = Cell(i, rand() % 2, row, column);
+        current[i] = Cell(i, input[i], row, column);
         future[i] = Cell(i, 0, row, column);
       }
     }
 
-    // Constructor initializing the table with input values
-    Table(int height, int width, vector<int> input):
+    // Constructor initializing the table with the values of the given buffer
+    Table(int height, int width, int* buffer):
       height(height), width(width) {
-      int size = height * width;
-      int column, row;
+      long size = (long) height * width;
+      long column, row;
       current = new Cell[size];
       future = new Cell[size];
-      for (int i = 0; i < size; i++) {
+      for (long i = 0; i < size; i++) {
         row = i / width;
         column = i % width;
-        current[i] = Cell(i, input[i], row, column);
+        current[i] = Cell(i, buffer[i], row, column);
         future[i] = Cell(i, 0, row, column);
       }
     }
 
+    /**
+     * Populate the matrix with random values cells
+     */
+    void generate() {
+      generate(rand(), 0.5, 0, height * width);
+    }
+
+    /**
+     * Populate a stripe of the matrix with random values cells. Each cell only
+     * depends on the seed and on its index, so stripes can be generated in
+     * parallel, each one by the thread that will compute it
+     * 
+     * @param seed seed of the generator
+     * @param density probability of a cell being alive
+     * @param start index of the first cell of the stripe
+     * @param stop index past the last cell of the stripe
+     */
+    void generate(uint64_t seed, double density, long start, long stop) {
+      uint64_t threshold = densityThreshold(density);
+      for (long i = start; i < stop; i++) {
+        current[i] = Cell(i, randomCell(seed, threshold, i), i / width, i % width);
+        future[i] = Cell(i, 0, i / width, i % width);
+      }
+    }
+
     // Getters
     Cell* getCurrent() { return current; }
 
-    int getCellValue(int i) {
+    int getCellValue(long i) {
       return current[i].getValue();
     }
 
-    // Setter
-    void setFuture(int index, int value) {
+    // Setters
+    void setFuture(long index, int value) {
       future[index].setValue(value);
     }
 
+    void setCurrent(long index, int value) {
+      current[index].setValue(value);
+    }
+
+
+    /**
+     * Returns a read-only view over the current state of the matrix, valid until
+     * the next swap
+     */
+    GridView view() {
+      GridView v(width, sizeof(Cell));
+      for (long i = 0; i < height; i++) {
+        v.addRow(current[i * width].getValueAddress());
+      }
+      return v;
+    }
 
     /**
      * Prints the current state of the matrix
      */
     void printCurrent() {
-      for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
+      string text;
+      text.reserve(height * (width + 1) + 1);
+      for (long i = 0; i < height; i++) {
+        for (long j = 0; j < width; j++) {
           int v = current[i * width + j].getValue();
-          if (v == 0) cout << "-";
-          else cout << "x";
+          text.push_back(v == 0 ? '-' : 'x');
         }
-        cout << endl;
+        text.push_back('\n');
       }
-      cout << endl;
+      text.push_back('\n');
+      cout.write(text.data(), text.size()).flush();
     }
 
     /**
      * Prints the next state of the matrix
      */
     void printFuture() {
-      for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
+      string text;
+      text.reserve(height * (width + 1) + 1);
+      for (long i = 0; i < height; i++) {
+        for (long j = 0; j < width; j++) {
           int v = future[i * width + j].getValue();
-          if (v == 0) cout << "-";
-          else cout << "x";
+          text.push_back(v == 0 ? '-' : 'x');
         }
-        cout << endl;
+        text.push_back('\n');
       }
-      cout << endl;
+      text.push_back('\n');
+      cout.write(text.data(), text.size()).flush();
     }
 
     /**
@@ -156,12 +215,12 @@ class Table {
      * @param i index of the cell in examination
      * @returns a vector containing the 8 values of the cell's neighbourhood
      */
-    vector<int> getNeighbours(int i) {   
-      long x1 = width * (mod(current[i].getRow() - 1, width));
-      long x2 = width * (mod(current[i].getRow() + 1, width));
-      long x3 = width * (mod(current[i].getRow(), width));
-      long y1 = mod(current[i].getColumn() - 1, height);
-      long y2 = mod(current[i].getColumn() + 1, height);
+    vector<int> getNeighbours(long i) {   
+      long x1 = width * (mod(current[i].getRow() - 1, height));
+      long x2 = width * (mod(current[i].getRow() + 1, height));
+      long x3 = width * (mod(current[i].getRow(), height));
+      long y1 = mod(current[i].getColumn() - 1, width);
+      long y2 = mod(current[i].getColumn() + 1, width);
 
       vector<int> arr = 
                 {
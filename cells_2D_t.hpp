@@ -1,7 +1,11 @@
 #include <iostream>
 #include <cstdlib>
+#include <string>
 #include <vector>
 
+#include "random.hpp"
+#include "view.hpp"
+
 using namespace std;
 
 /**
@@ -46,6 +50,8 @@ class Cell {
     int getValue() { return value; }
     int getRow() { return row; }
     int getColumn() { return column; }
+    // address of the value, read by the views of the table
+    const int* getValueAddress() { return &value; }
 
     // Setter
     void setValue(int v) { value = v; }
@@ -78,7 +84,7 @@ class Table {
     }
 
     // Constructor initializing the table with input values
-    Table(long height, long width, vector<int> input):
+    Table(long height, long width, const vector<int>& input):
       height(height), width(width) {
       size = height * width;
       for (long i = 0; i < height; i++) {
@@ -95,21 +101,59 @@ class Table {
       }
     }
 
-    /**
-     * Populate the matrix with random values cells
-     */
-    void generate() {
+    // Constructor initializing the table with the values of the given row-major buffer
+    Table(long height, long width, int* buffer):
+      height(height), width(width) {
+      size = height * width;
       for (long i = 0; i < height; i++) {
         current_rows->push_back(vector<Cell>());
         future_rows->push_back(vector<Cell>());
+        for (long j = 0; j < width; j++) {
+          current_rows->at(i).push_back(Cell(i * width + j, buffer[i * width + j], i, j));
+          future_rows->at(i).push_back(Cell(i * width + j, 0, i, j));
+        }
       }
+    }
 
-      for (long i = 0; i < size; i++) {
-        long column, row;
-        row = i / width;
-        column = i % width;
-        current_rows->at(row).push_back(Cell(i, rand() % 2, row, column));
-        future_rows->at(row).push_back(Cell(i, 0, row, column));
+    /**
+     * Populate the matrix with random values cells
+     */
+    void generate() {
+      allocateRows();
+      generate(rand(), 0.5, 0, height);
+    }
+
+    /**
+     * Creates the (empty) rows of the matrix, to be populated by generate
+     */
+    void allocateRows() {
+      current_rows->resize(height);
+      future_rows->resize(height);
+    }
+
+    /**
+     * Populate a stripe of rows of the matrix with random values cells. Each cell
+     * only depends on the seed and on its index, so stripes can be generated in
+     * parallel, each one by the thread that will compute it
+     * 
+     * @param seed seed of the generator
+     * @param density probability of a cell being alive
+     * @param rows_start index of the first row of the stripe
+     * @param rows_stop index past the last row of the stripe
+     */
+    void generate(uint64_t seed, double density, long rows_start, long rows_stop) {
+      uint64_t threshold = densityThreshold(density);
+      for (long i = rows_start; i < rows_stop; i++) {
+        row current_row;
+        row future_row;
+        current_row.reserve(width);
+        future_row.reserve(width);
+        for (long j = 0; j < width; j++) {
+          current_row.push_back(Cell(i * width + j, randomCell(seed, threshold, i * width + j), i, j));
+          future_row.push_back(Cell(i * width + j, 0, i, j));
+        }
+        (*current_rows)[i] = move(current_row);
+        (*future_rows)[i] = move(future_row);
       }
     }
 
@@ -152,34 +196,50 @@ class Table {
       current_rows->at(row)[column].setValue(value);
     }
     
+    /**
+     * Returns a read-only view over the current state of the matrix, valid until
+     * the next swap
+     */
+    GridView view() {
+      GridView v(width, sizeof(Cell));
+      for (long i = 0; i < height; i++) {
+        v.addRow((*current_rows)[i][0].getValueAddress());
+      }
+      return v;
+    }
+
     /**
      * Prints the current state of the matrix
      */
     void printCurrent() {
+      string text;
+      text.reserve(height * (width + 1) + 1);
       for (long i = 0; i < height; i++) {
         for (long j = 0; j < width; j++) {
           int v = current_rows->at(i).at(j).getValue();
-          if (v == 0) cout << "-";
-          else cout << "x";
+          text.push_back(v == 0 ? '-' : 'x');
         }
-        cout << endl;
+        text.push_back('\n');
       }
-      cout << endl;
+      text.push_back('\n');
+      cout.write(text.data(), text.size()).flush();
     }
 
     /**
      * Prints the next state of the matrix
      */
     void printFuture() {
+      string text;
+      text.reserve(height * (width + 1) + 1);
       for (long i = 0; i < height; i++) {
         for (long j = 0; j < width; j++) {
           int v = future_rows->at(i).at(j).getValue();
-          if (v == 0) cout << "-";
-          else cout << "x";
+          text.push_back(v == 0 ? '-' : 'x');
         }
-        cout << endl;
+        text.push_back('\n');
       }
-      cout << endl;
+      text.push_back('\n');
+      cout.write(text.data(), text.size()).flush();
     }
 
     /**
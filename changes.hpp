@@ -0,0 +1,79 @@
+/**
+ * Dirty rectangles of a generation, derived from the per-tile counts of the
+ * cells which changed state in the last step.
+ *
+ * The counts are kept by a DensityPyramid fed by the workers with the changed
+ * cells instead of the live ones: a tile of level 0 (8x8 cells) is dirty when
+ * its count is not 0. Runs of dirty tiles on a row of tiles are merged, and runs
+ * spanning the same columns on consecutive rows of tiles are merged into a
+ * single rectangle.
+ */
+#ifndef CHANGES_HPP
+#define CHANGES_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "pyramid.hpp"
+
+using namespace std;
+
+/**
+ * Rectangle of cells containing changes
+ */
+struct DirtyRect {
+  long row;
+  long column;
+  long height;
+  long width;
+};
+
+/**
+ * Computes the dirty rectangles from the change counts of a generation
+ *
+ * @param changes counts of the changed cells of each tile
+ * @param height number of rows of the automaton
+ * @param width number of columns of the automaton
+ * @returns rectangles, in cells, covering all the dirty tiles
+ */
+inline vector<DirtyRect> dirtyRectangles(DensityPyramid& changes, long height, long width) {
+  long side = changes.getSide(0);
+  long rows = changes.getRows(0);
+  long columns = changes.getColumns(0);
+  const uint32_t* counts = changes.getLevel(0).data();
+  vector<DirtyRect> done;
+  // rectangles extending to the previous row of tiles, in tiles, sorted by column
+  vector<DirtyRect> open;
+  vector<DirtyRect> next;
+  for (long r = 0; r <= rows; r++) {
+    next.clear();
+    size_t o = 0;
+    long c = 0;
+    while (r < rows && c < columns) {
+      if (counts[r * columns + c] == 0) {
+        c++;
+        continue;
+      }
+      long first = c;
+      while (c < columns && counts[r * columns + c] != 0) c++;
+      // close the open rectangles left of the run
+      while (o < open.size() && open[o].column < first) done.push_back(open[o++]);
+      if (o < open.size() && open[o].column == first && open[o].width == c - first) {
+        next.push_back(open[o++]);
+        next.back().height++;
+      }
+      else next.push_back({r, first, 1, c - first});
+    }
+    while (o < open.size()) done.push_back(open[o++]);
+    swap(open, next);
+  }
+  for (auto& d : done) {
+    d.height = min((d.row + d.height) * side, height) - d.row * side;
+    d.width = min((d.column + d.width) * side, width) - d.column * side;
+    d.row *= side;
+    d.column *= side;
+  }
+  return done;
+}
+
+#endif
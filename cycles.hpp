@@ -0,0 +1,139 @@
+/**
+ * Detection of still lifes and oscillators through an incremental hash of the
+ * generations.
+ *
+ * The hash of a generation is the sum, modulo 2^64, of a position-dependent
+ * random value for every cell which is not dead. It does not depend on how the
+ * table is divided among the workers and can be updated incrementally: while
+ * computing a step each worker only hashes the cells of its stripe which change
+ * state, and the differences are added to the hash at the barrier. A repeated
+ * hash within a window of recent generations is reported as a cycle, with a
+ * probability of false positives of about window / 2^64 per step.
+ */
+#ifndef CYCLES_HPP
+#define CYCLES_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "random.hpp"
+
+using namespace std;
+
+/**
+ * @returns the contribution of a cell to the hash of its generation
+ */
+inline uint64_t cellHash(long index, int value) {
+  return value == 0 ? 0 : counterRandom(value, index);
+}
+
+/**
+ * Difference of the hash of a stripe, owned by a single worker
+ */
+struct TileHash {
+  uint64_t delta;
+  // keeps the hashes of different workers on different cache lines
+  char padding[56];
+};
+
+/**
+ * Class keeping the hashes of the recent generations
+ */
+class CycleDetector {
+  private:
+    vector<TileHash> tiles;
+    // hash of the current generation
+    uint64_t hash;
+    // hashes and generations of the last window generations, in a ring
+    vector<uint64_t> hashes;
+    vector<long> generations;
+    // number of generations stored
+    long stored;
+    // period of the detected cycle, 0 if none
+    long period;
+    // first generation found to repeat an earlier one
+    long repeated;
+
+    // stores the hash of the current generation in the ring
+    void remember(long generation) {
+      long slot = stored % hashes.size();
+      hashes[slot] = hash;
+      generations[slot] = generation;
+      stored++;
+    }
+
+  public:
+    // Default constructor, no cycle detected
+    CycleDetector(): hash(0), stored(0), period(0), repeated(-1) {}
+
+    /**
+     * Constructor
+     *
+     * @param nw number of workers
+     * @param window number of recent generations compared with the current one,
+     * i.e. the longest period detected
+     */
+    CycleDetector(int nw, int window) {
+      tiles = vector<TileHash>(nw);
+      hashes = vector<uint64_t>(window);
+      generations = vector<long>(window);
+      reset(0, 0);
+    }
+
+    /**
+     * Forgets the history, restarting from a generation with the given hash
+     */
+    void reset(long generation, uint64_t h) {
+      hash = h;
+      stored = 0;
+      period = 0;
+      repeated = -1;
+      for (auto& t : tiles) {
+        t.delta = 0;
+      }
+      remember(generation);
+    }
+
+    /**
+     * @returns the difference of the hash of the given worker, to be updated
+     * with the cells of its stripe changing state during a step
+     */
+    uint64_t& tile(int id) { return tiles[id].delta; }
+
+    /**
+     * Adds the differences of the first nw workers to the hash of the previous
+     * generation and compares the result with the recent generations
+     *
+     * @param generation generation computed by the workers
+     * @param nw number of workers which swept a stripe
+     * @returns true if the generation repeats a recent one
+     */
+    bool step(long generation, int nw) {
+      for (int i = 0; i < nw; i++) {
+        hash += tiles[i].delta;
+        tiles[i].delta = 0;
+      }
+      long window = hashes.size();
+      long count = stored < window ? stored : window;
+      bool found = false;
+      for (long k = 1; k <= count && !found; k++) {
+        long slot = (stored - k) % window;
+        if (hashes[slot] == hash) {
+          found = true;
+          if (repeated < 0) {
+            period = generation - generations[slot];
+            repeated = generation;
+          }
+        }
+      }
+      remember(generation);
+      return found;
+    }
+
+    // Getters
+    uint64_t getHash() { return hash; }
+    long getPeriod() { return period; }
+    long getRepeatedGeneration() { return repeated; }
+};
+
+#endif
@@ -0,0 +1,509 @@
+/**
+ * Delta-compressed recording of the evolution of the automaton.
+ *
+ * A recording starts with a keyframe holding the alive / dead state of every
+ * cell as a bitmap, followed by one delta per generation. Each worker builds,
+ * while writing the future, the XOR bitmap of the cells of its stripe whose
+ * state changed, compressed with a run-length encoding of 64 bits words: the
+ * stripes are stored as independent segments of the delta. The periodic
+ * keyframes are also encoded by the workers, as one bitmap segment per stripe.
+ * At the barrier the segments are only handed to a writer thread, which writes
+ * them to the file while the simulation goes on. Cells are treated as alive
+ * when their value is not 0.
+ *
+ * File layout, all integers serialized as little endian:
+ *   header:   magic[8] version(u32) reserved(u32) height(u64) width(u64)
+ *   record:   type('K' or 'D') generation(u64) segments(u32)
+ *             then for each segment first(u64) cells(u64) bytes(u64) data
+ * A keyframe follows the delta of the same generation, if any. Keyframe data is
+ * the bitmap of the cells of the segment, packed in 64 bits words whose bit b
+ * is the cell first + 64 * w + b. Delta data is a sequence of runs: varint
+ * number of all-zero words, varint number of literal words, literal words (u64
+ * each).
+ */
+#ifndef DELTA_HPP
+#define DELTA_HPP
+
+#include <cstdio>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "byte_order.hpp"
+
+using namespace std;
+
+// identifies a delta recording
+const char DELTA_MAGIC[8] = {'C', 'A', 'D', 'E', 'L', 'T', 'A', 0};
+// current version of the format
+const uint32_t DELTA_VERSION = 2;
+
+/**
+ * Appends an unsigned integer with a variable-length encoding
+ */
+inline void putVarint(vector<uint8_t>& out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t) (v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t) v);
+}
+
+/**
+ * Reads an unsigned integer written by putVarint, from a buffer ending at end
+ */
+inline uint64_t getVarint(const uint8_t*& p, const uint8_t* end) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (p == end) throw "Invalid recording file";
+    uint8_t b = *p++;
+    v |= (uint64_t) (b & 0x7f) << shift;
+    if ((b & 0x80) == 0) return v;
+  }
+  throw "Invalid recording file";
+}
+
+/**
+ * Class encoding the XOR bitmap of a stripe, owned by a single worker
+ */
+class DeltaEncoder {
+  private:
+    // index of the first cell of the stripe
+    long first;
+    // number of cells pushed
+    long count;
+    // bits not yet flushed
+    uint64_t word;
+    int bits;
+    // pending run: zero words followed by literal words
+    uint64_t zeros;
+    vector<uint64_t> literals;
+    // encoded runs
+    vector<uint8_t> data;
+
+    // whether the state of the cells is also encoded, for a keyframe
+    bool keying;
+    // bits of the state not yet flushed
+    uint64_t keyWord;
+    // encoded keyframe bitmap
+    vector<uint8_t> keyData;
+
+    void flushRun() {
+      putVarint(data, zeros);
+      putVarint(data, literals.size());
+      for (uint64_t l : literals) {
+        putLittleEndian(data, l, 8);
+      }
+      zeros = 0;
+      literals.clear();
+    }
+
+    void flushWord() {
+      if (word == 0) {
+        if (!literals.empty()) flushRun();
+        zeros++;
+      }
+      else literals.push_back(word);
+      if (keying) putLittleEndian(keyData, keyWord, 8);
+      word = 0;
+      keyWord = 0;
+      bits = 0;
+    }
+
+  public:
+    /**
+     * Starts the encoding of a stripe
+     *
+     * @param start index of the first cell of the stripe
+     * @param key whether to also encode the state of the cells for a keyframe
+     */
+    void begin(long start, bool key = false) {
+      first = start;
+      count = 0;
+      word = 0;
+      bits = 0;
+      zeros = 0;
+      keying = key;
+      keyWord = 0;
+      literals.clear();
+      data.clear();
+      keyData.clear();
+    }
+
+    /**
+     * Appends the next cell of the stripe
+     *
+     * @param changed whether the cell changed state
+     * @param alive whether the cell is alive in the new generation
+     */
+    void push(bool changed, bool alive) {
+      word |= (uint64_t) changed << bits;
+      keyWord |= (uint64_t) alive << bits;
+      count++;
+      if (++bits == 64) flushWord();
+    }
+
+    /**
+     * Completes the encoding of the stripe
+     */
+    void end() {
+      if (bits > 0) flushWord();
+      if (zeros > 0 || !literals.empty()) flushRun();
+    }
+
+    /**
+     * Exchanges the encoded delta, or the encoded keyframe, with the given
+     * buffer, so that it can be written without being copied
+     */
+    void exchange(vector<uint8_t>& buffer, bool key) { swap(buffer, key ? keyData : data); }
+
+    // Getters
+    long getFirst() { return first; }
+    long getCount() { return count; }
+    bool isKeying() { return keying; }
+};
+
+/**
+ * Class writing a recording, fed by the Game with one encoder per worker. The
+ * records are queued as buffers swapped with the encoders and written by a
+ * dedicated writer thread, the buffers being recycled once written
+ */
+class DeltaRecorder {
+  private:
+    FILE* file;
+    long height;
+    long width;
+    // a keyframe is written every keyEvery generations, 0 for only the first one
+    long keyEvery;
+    // number of bytes of the records queued
+    atomic<long> written;
+    vector<DeltaEncoder> encoders;
+    // records waiting to be written, each one a sequence of buffers
+    deque<vector<vector<uint8_t>>> queue;
+    // written buffers, ready to be reused
+    vector<vector<uint8_t>> spares;
+    // maximum number of records waiting, the Game waits for the writer beyond it
+    size_t maxPending;
+    mutex m;
+    // signaled when a record is queued or the recorder is closed
+    condition_variable queued;
+    // signaled when a record has been written
+    condition_variable drained;
+    bool closing;
+    thread writer;
+
+    DeltaRecorder(const DeltaRecorder&) = delete;
+    DeltaRecorder& operator=(const DeltaRecorder&) = delete;
+
+    /**
+     * Body of the writer thread
+     */
+    void writeLoop() {
+      while (true) {
+        vector<vector<uint8_t>> record;
+        {
+          unique_lock<mutex> lock(m);
+          queued.wait(lock, [&] { return !queue.empty() || closing; });
+          if (queue.empty()) return;
+          record = move(queue.front());
+          queue.pop_front();
+        }
+        for (auto& b : record) {
+          fwrite(b.data(), 1, b.size(), file);
+        }
+        {
+          unique_lock<mutex> lock(m);
+          for (auto& b : record) {
+            b.clear();
+            spares.push_back(move(b));
+          }
+        }
+        drained.notify_one();
+      }
+    }
+
+    /**
+     * @returns an empty buffer, recycled if possible
+     */
+    vector<uint8_t> spare() {
+      unique_lock<mutex> lock(m);
+      if (spares.empty()) return vector<uint8_t>();
+      vector<uint8_t> b = move(spares.back());
+      spares.pop_back();
+      return b;
+    }
+
+    /**
+     * Hands a record to the writer thread, waiting if too many are pending
+     */
+    void enqueue(vector<vector<uint8_t>>& record) {
+      for (auto& b : record) {
+        written += b.size();
+      }
+      {
+        unique_lock<mutex> lock(m);
+        drained.wait(lock, [&] { return queue.size() < maxPending; });
+        queue.push_back(move(record));
+      }
+      queued.notify_one();
+    }
+
+    /**
+     * Appends a record made of the segments of the encoders of the first nw workers
+     */
+    void segments(vector<vector<uint8_t>>& record, char type, long generation, int nw) {
+      record.push_back(spare());
+      putLittleEndian(record.back(), type, 1);
+      putLittleEndian(record.back(), generation, 8);
+      putLittleEndian(record.back(), nw, 4);
+      for (int i = 0; i < nw; i++) {
+        vector<uint8_t> data = spare();
+        encoders[i].exchange(data, type == 'K');
+        record.push_back(spare());
+        putLittleEndian(record.back(), encoders[i].getFirst(), 8);
+        putLittleEndian(record.back(), encoders[i].getCount(), 8);
+        putLittleEndian(record.back(), data.size(), 8);
+        record.push_back(move(data));
+      }
+    }
+
+  public:
+    /**
+     * Constructor, writes the header of the recording and starts the writer thread
+     *
+     * @param path path of the recording
+     * @param height number of rows of the automaton
+     * @param width number of columns of the automaton
+     * @param keyEvery period of the keyframes, 0 for a single keyframe
+     * @param pending number of records which can wait to be written
+     */
+    DeltaRecorder(const char* path, long height, long width, long keyEvery = 0, int pending = 64):
+      height(height), width(width), keyEvery(keyEvery) {
+        if (height <= 0 || width <= 0 || keyEvery < 0 || pending <= 0) {
+          throw "Invalid parameters, check framework API";
+        }
+        file = fopen(path, "wb");
+        if (file == nullptr) throw "Cannot open the recording file";
+        vector<uint8_t> header(DELTA_MAGIC, DELTA_MAGIC + sizeof(DELTA_MAGIC));
+        putLittleEndian(header, DELTA_VERSION, 4);
+        putLittleEndian(header, 0, 4);
+        putLittleEndian(header, height, 8);
+        putLittleEndian(header, width, 8);
+        fwrite(header.data(), 1, header.size(), file);
+        written = header.size();
+        maxPending = pending;
+        closing = false;
+        writer = thread(&DeltaRecorder::writeLoop, this);
+    }
+
+    // Destructor
+    ~DeltaRecorder() {
+      close();
+      fclose(file);
+    }
+
+    // Getters
+    long getHeight() { return height; }
+    long getWidth() { return width; }
+    long getBytesWritten() { return written.load(); }
+
+    /**
+     * @returns true if a keyframe has to be written for the given generation
+     */
+    bool wantsKeyframe(long generation) { return keyEvery > 0 && generation % keyEvery == 0; }
+
+    /**
+     * Sets the number of workers, each one owning an encoder
+     */
+    void setWorkers(int nw) { encoders.resize(nw); }
+
+    /**
+     * @returns the encoder of the given worker
+     */
+    DeltaEncoder& encoder(int id) { return encoders[id]; }
+
+    /**
+     * Writes a keyframe of a single segment, reading the cells through the given
+     * table. Used for the first keyframe, the periodic ones being encoded by the
+     * workers
+     *
+     * @param generation generation of the keyframe
+     * @param table the table, providing getCellValue
+     */
+    template<class T>
+    void keyframe(long generation, T& table) {
+      long size = height * width;
+      vector<vector<uint8_t>> record;
+      record.push_back(spare());
+      putLittleEndian(record.back(), 'K', 1);
+      putLittleEndian(record.back(), generation, 8);
+      putLittleEndian(record.back(), 1, 4);
+      putLittleEndian(record.back(), 0, 8);
+      putLittleEndian(record.back(), size, 8);
+      putLittleEndian(record.back(), (size + 63) / 64 * 8, 8);
+      record.push_back(spare());
+      for (long w = 0; w < size; w += 64) {
+        uint64_t word = 0;
+        for (long b = 0; b < 64 && w + b < size; b++) {
+          word |= (uint64_t) (table.getCellValue(w + b) != 0) << b;
+        }
+        putLittleEndian(record.back(), word, 8);
+      }
+      enqueue(record);
+    }
+
+    /**
+     * Queues the delta produced by the encoders of the first nw workers, followed
+     * by the keyframe they encoded, if any
+     *
+     * @param generation generation obtained applying the delta
+     * @param nw number of workers which encoded a stripe
+     */
+    void commit(long generation, int nw) {
+      vector<vector<uint8_t>> record;
+      segments(record, 'D', generation, nw);
+      if (nw > 0 && encoders[0].isKeying()) segments(record, 'K', generation, nw);
+      enqueue(record);
+    }
+
+    /**
+     * Writes the pending records and stops the writer thread
+     */
+    void close() {
+      {
+        unique_lock<mutex> lock(m);
+        if (closing) return;
+        closing = true;
+      }
+      queued.notify_one();
+      writer.join();
+      fflush(file);
+    }
+};
+
+/**
+ * Class replaying a recording, one keyframe or delta at a time
+ */
+class DeltaPlayer {
+  private:
+    FILE* file;
+    long height;
+    long width;
+    long generation;
+    // alive / dead state of the cells
+    vector<uint8_t> cells;
+    vector<uint8_t> data;
+
+    bool get(void* p, size_t n) { return fread(p, 1, n, file) == n; }
+
+    // reads a little endian unsigned integer
+    bool get(uint64_t& v, int bytes) {
+      uint8_t b[8];
+      if (!get(b, bytes)) return false;
+      v = getLittleEndian(b, bytes);
+      return true;
+    }
+
+    // sets the cells of a keyframe segment
+    void load(long first, long count, const uint8_t* p) {
+      for (long i = 0; i < count; i++) {
+        cells[first + i] = p[i / 8] >> (i % 8) & 1;
+      }
+    }
+
+    // flips the cells marked in a segment of the given bytes, every run having
+    // to lie within the cells of the segment
+    void apply(long first, long count, const uint8_t* p, size_t bytes) {
+      const uint8_t* end = p + bytes;
+      uint64_t words = (count + 63) / 64;
+      uint64_t w = 0;
+      while (w < words) {
+        uint64_t zeros = getVarint(p, end);
+        uint64_t literals = getVarint(p, end);
+        if (zeros > words - w || literals > words - w - zeros || literals > (uint64_t) (end - p) / 8) {
+          throw "Invalid recording file";
+        }
+        w += zeros;
+        for (uint64_t l = 0; l < literals; l++, w++) {
+          uint64_t word = getLittleEndian(p, 8);
+          p += 8;
+          long i = first + 64 * w;
+          for (int b = 0; b < 64 && i + b < first + count; b++) {
+            if (word >> b & 1) cells[i + b] ^= 1;
+          }
+        }
+      }
+      if (p != end) throw "Invalid recording file";
+    }
+
+  public:
+    /**
+     * Constructor, reads the header of the recording
+     */
+    DeltaPlayer(const char* path) {
+      file = fopen(path, "rb");
+      if (file == nullptr) throw "Cannot open the recording file";
+      char magic[8];
+      uint64_t version, reserved, h, w;
+      if (!get(magic, sizeof(magic)) || memcmp(magic, DELTA_MAGIC, sizeof(magic)) != 0
+          || !get(version, 4) || version != DELTA_VERSION || !get(reserved, 4) || !get(h, 8) || !get(w, 8)) {
+        fclose(file);
+        throw "Invalid recording file";
+      }
+      if (h == 0 || w == 0 || h > (uint64_t) LONG_MAX / w) {
+        fclose(file);
+        throw "Invalid recording file";
+      }
+      height = h;
+      width = w;
+      generation = -1;
+      cells = vector<uint8_t>(height * width, 0);
+    }
+
+    // Destructor
+    ~DeltaPlayer() { fclose(file); }
+
+    // Getters
+    long getHeight() { return height; }
+    long getWidth() { return width; }
+    long getGeneration() { return generation; }
+    // row-major alive (1) / dead (0) state of the cells
+    const vector<uint8_t>& getCells() { return cells; }
+
+    /**
+     * Reads the next keyframe or delta
+     *
+     * @returns false at the end of the recording
+     */
+    bool next() {
+      uint64_t type, gen, segments;
+      if (!get(type, 1)) return false;
+      if (!get(gen, 8)) throw "Truncated recording file";
+      generation = gen;
+      if (type != 'K' && type != 'D') throw "Invalid recording file";
+      if (!get(segments, 4)) throw "Truncated recording file";
+      for (uint64_t s = 0; s < segments; s++) {
+        uint64_t first, count, bytes;
+        if (!get(first, 8) || !get(count, 8) || !get(bytes, 8)) throw "Truncated recording file";
+        // a delta run takes at most two varints and a literal per word
+        uint64_t words = (count + 63) / 64;
+        if (first > cells.size() || count > cells.size() - first
+            || (type == 'K' && bytes < (count + 7) / 8) || bytes > 28 * words) {
+          throw "Invalid recording file";
+        }
+        data.resize(bytes);
+        if (!get(data.data(), data.size())) throw "Truncated recording file";
+        if (type == 'K') load(first, count, data.data());
+        else apply(first, count, data.data(), bytes);
+      }
+      return true;
+    }
+};
+
+#endif
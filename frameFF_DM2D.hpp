@@ -215,7 +215,7 @@ class Game {
     }
 
     // Constructor initializing table with input vector
-    Game(long height, long width, int nw, vector<int> input):
+    Game(long height, long width, int nw, const vector<int>& input):
         nw(nw), width(width) {
         if (nw <= 0 || width <= 0 || height <= 0) {
           throw "Invalid parameters, check framework API";
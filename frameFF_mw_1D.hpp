@@ -13,9 +13,12 @@
 #include <ff/ff.hpp>
 #include <ff/farm.hpp>
 
-//#include "cells_1D_t.hpp"
-// ints are slightly more performing
+// ints are slightly more performing, define CELLS to employ cells
+#ifdef CELLS
+#include "cells_1D_t.hpp"
+#else
 #include "ints_1D_t.hpp"
+#endif
 
 // redefining clock from chrono library for easier use
 typedef std::chrono::high_resolution_clock Clock;
@@ -163,11 +166,12 @@ class Game {
         throw "Invalid parameters, check framework API";
       }
       table = Table(height, width);
+      table.generate();
       size = height * width;
     }
 
     // Constructor with initialization of the matrix values
-    Game(long height, long width, int nw, vector<int> input):
+    Game(long height, long width, int nw, const vector<int>& input):
       nw(nw) {
       if (nw <= 0 || width <= 0 || height <= 0) {
         throw "Invalid parameters, check framework API";
@@ -15,8 +15,28 @@
 #include <cstdlib>
 #include <chrono>
 
+// Employ the cells table implementation
+#ifdef CELLS
+#include "cells_2D_t.hpp"
+#else
 #include "ints_2D_t.hpp"
-//#include "cells_2D_t.hpp"
+#endif
+#include "balance.hpp"
+#include "run_control.hpp"
+#include "snapshot.hpp"
+#include "stream.hpp"
+#include "video.hpp"
+#include "shm_ring.hpp"
+#include "delta.hpp"
+#include "loaders.hpp"
+#include "reductions.hpp"
+#include "cycles.hpp"
+#include "pyramid.hpp"
+#include "changes.hpp"
+#include "render.hpp"
+#include "trace.hpp"
+#include "perf_counters.hpp"
+#include "metrics.hpp"
 
 // redefining clock from chrono library for easier use
 typedef std::chrono::high_resolution_clock Clock;
@@ -34,13 +54,13 @@ class Game {
     // game table
     Table table;
     // number of workers
-    int nw;
+    int nw = 0;
     // number of steps
-    int nSteps;
+    int nSteps = 0;
     // number of Cells
-    int size;
-    int height;
-    int width;
+    long size = 0;
+    int height = 0;
+    int width = 0;
     // wait here until nextStep is executable
     condition_variable nextStep;
     // wait here until a thread has completed a step
@@ -49,9 +69,126 @@ class Game {
     mutex m;
     mutex m1;
     // number of threads ready to get to the next step
-    atomic<int> threadsReady;
+    atomic<int> threadsReady{0};
     // number of threads completed
-    atomic<int> threadsDone;
+    atomic<int> threadsDone{0};
+    // boundaries of the stripes of rows assigned to the workers
+    vector<long> bounds;
+    // moves the boundaries according to the measured step times
+    Balancer balancer;
+    // whether the stripes are adaptively repartitioned
+    bool adaptive = false;
+    // number of times the workers have been released from the barrier in this run
+    int released = 0;
+    // set at a generation boundary to make the workers leave the run
+    atomic<bool> halt{false};
+    // number of generations computed since the construction
+    atomic<long> generation{0};
+    // control of the current asynchronous run, nullptr for synchronous runs
+    RunControl* control = nullptr;
+    // whether an asynchronous run is in progress
+    atomic<bool> running{false};
+    // control and result of the last asynchronous run, waited for before the Game goes away
+    shared_ptr<RunControl> asyncControl;
+    shared_future<double> asyncResult;
+    // owner of the memory of the table (snapshot or adopted buffer), kept alive with the Game
+    shared_ptr<void> source;
+    // output stage receiving the captured generations, nullptr if none
+    GenerationStream* stream = nullptr;
+    // buffer in which the workers copy their stripes during the next sweep
+    GenerationFrame* capture = nullptr;
+    // last generation captured
+    long capturedGeneration = -1;
+    // delta recording of the evolution, nullptr if none
+    DeltaRecorder* recorder = nullptr;
+    // shared-memory ring receiving the published generations, nullptr if none
+    ShmRing* ring = nullptr;
+    // slot of the ring in which the workers copy their stripes during the next sweep
+    uint8_t* ringCells = nullptr;
+    // last generation published
+    long publishedGeneration = -1;
+    // per-worker statistics of the generations, combined at every step
+    StepReducer reducer;
+    // whether the statistics are reduced during the sweeps
+    bool reducing = false;
+    // population counts of the blocks of the generations, at several resolutions
+    DensityPyramid pyramid;
+    // whether the pyramid is computed during the sweeps
+    bool pyramiding = false;
+    // counts of the cells of each tile which changed state in the last step
+    DensityPyramid changes;
+    // whether the changes are counted during the sweeps
+    bool tracking = false;
+    // hashes of the recent generations, to detect still lifes and oscillators
+    CycleDetector cycles;
+    // whether the generations are hashed during the sweeps
+    bool detecting = false;
+    // whether run() stops when a cycle is detected
+    bool stopOnCycle = false;
+    // whether the table was modified outside of a step and must be hashed again
+    bool hashStale = true;
+    // formats the generations to be printed or saved as images
+    Renderer renderer;
+    // timeline of the runs, nullptr if not traced
+    Tracer* tracer = nullptr;
+    // hardware counters of the compute phases, nullptr if not counted
+    PerfCounters* counters = nullptr;
+    // live metrics of the runs, nullptr if not published
+    LiveMetrics* metrics = nullptr;
+
+    /**
+     * Copies the state of another Game: the table, the partitioning and the
+     * features computed during the sweeps. The run control, the outputs and the
+     * instrumentation attached to the other Game are not shared with the copy.
+     */
+    void copyFrom(const Game& obj) {
+      table = obj.table;
+      nw = obj.nw;
+      nSteps = obj.nSteps;
+      size = obj.size;
+      height = obj.height;
+      width = obj.width;
+      bounds = obj.bounds;
+      balancer = obj.balancer;
+      adaptive = obj.adaptive;
+      generation = obj.generation.load();
+      source = obj.source;
+      reducer = obj.reducer;
+      reducing = obj.reducing;
+      pyramid = obj.pyramid;
+      pyramiding = obj.pyramiding;
+      changes = obj.changes;
+      tracking = obj.tracking;
+      cycles = obj.cycles;
+      detecting = obj.detecting;
+      stopOnCycle = obj.stopOnCycle;
+      renderer = obj.renderer;
+      threadsReady = 0;
+      threadsDone = 0;
+      control = nullptr;
+      running = false;
+      stream = nullptr;
+      capture = nullptr;
+      capturedGeneration = -1;
+      recorder = nullptr;
+      ring = nullptr;
+      ringCells = nullptr;
+      publishedGeneration = -1;
+      hashStale = true;
+      tracer = nullptr;
+      counters = nullptr;
+      metrics = nullptr;
+    }
+
+    /**
+     * Cancels the last asynchronous run and waits for its end, so that no worker
+     * is left computing on a Game being destroyed or overwritten
+     */
+    void stopAsync() {
+      if (!asyncResult.valid()) return;
+      asyncControl->cancelled = true;
+      asyncResult.wait();
+    }
 
   public:
     // Default constructor
@@ -60,70 +197,617 @@ class Game {
     // Copy constructor (must be explicitly declared if class has non-copyable member)
     Game(const Game& obj) 
     {
-      table = obj.table;
-      nw = obj.nw;
-      nSteps = obj.nSteps;
-      size = obj.size;
+      copyFrom(obj);
     }
     Game& operator=(const Game&& obj) // Move constructor (must be explicitly declared if class has non-copyable member)
     {
-      table = obj.table;
-      nw = obj.nw;
-      nSteps = obj.nSteps;
-      size = obj.size;
+      stopAsync();
+      copyFrom(obj);
       return *this;
     }
 
+    // Destructor, stopping an asynchronous run still in progress. The Game, and
+    // the members of a subclass used by rule(), must outlive the RunHandles: by
+    // the time this destructor runs the subclass is already destroyed
+    virtual ~Game() {
+      stopAsync();
+    }
+
     // Constructor
     Game(int height, int width, int nw):
-      height(height), width(width), nw(nw) {
+      nw(nw), height(height), width(width) {
         if (nw <= 0 || width <= 0 || height <= 0) {
           throw "Invalid parameters, check framework API";
         }
         table = Table(height, width);
-        table.generate();
-        size = height * width;
-        threadsReady = 0;
-        threadsDone = 0;
+        size = (long) height * width;
+        renderer = Renderer(nw);
+        setAdaptive(false);
+        generate(rand(), 0.5);
     }
 
-    Game(int height, int width, int nw, vector<int> input):
-      height(height), width(width), nw(nw) {
+    // Constructor initializing the matrix with random cells, alive with the given
+    // probability, the same for every number of workers
+    Game(int height, int width, int nw, uint64_t seed, double density):
+      nw(nw), height(height), width(width) {
+        if (nw <= 0 || width <= 0 || height <= 0 || !(density >= 0 && density <= 1)) {
+          throw "Invalid parameters, check framework API";
+        }
+        table = Table(height, width);
+        size = (long) height * width;
+        renderer = Renderer(nw);
+        setAdaptive(false);
+        generate(seed, density);
+    }
+
+    Game(int height, int width, int nw, const vector<int>& input):
+      nw(nw), height(height), width(width) {
         if (nw <= 0 || width <= 0 || height <= 0) {
           throw "Invalid parameters, check framework API";
         }
         table = Table(height, width, input);
-        size = height * width;
-        threadsReady = 0;
-        threadsDone = 0;
+        size = (long) height * width;
+        renderer = Renderer(nw);
+        setAdaptive(false);
+    }
+
+    // Constructor using the given row-major buffer as the matrix: the ints_1D_t.hpp
+    // table computes on it in place, overwriting it, the other tables copy it. The
+    // buffer is owned by the caller and must outlive the Game
+    Game(int height, int width, int nw, int* cells):
+      nw(nw), height(height), width(width) {
+        if (nw <= 0 || width <= 0 || height <= 0 || cells == nullptr) {
+          throw "Invalid parameters, check framework API";
+        }
+        table = Table(height, width, cells);
+        size = (long) height * width;
+        renderer = Renderer(nw);
+        setAdaptive(false);
+    }
+
+    // Constructor adopting the given row-major buffer as the matrix, which is freed
+    // with the Game
+    Game(int height, int width, int nw, unique_ptr<int[]> cells):
+      Game(height, width, nw, cells.get()) {
+        source = shared_ptr<int>(cells.release(), default_delete<int[]>());
+    }
+
+    // Constructor restoring the matrix from a snapshot, which can have been saved
+    // with a different number of workers
+    Game(int nw, shared_ptr<Snapshot> snapshot):
+      nw(nw) {
+        if (nw <= 0 || !snapshot || snapshot->getHeight() > INT_MAX || snapshot->getWidth() > INT_MAX) {
+          throw "Invalid parameters, check framework API";
+        }
+        height = snapshot->getHeight();
+        width = snapshot->getWidth();
+        table = Table(height, width, snapshot->getCells());
+        source = snapshot;
+        size = (long) height * width;
+        generation = snapshot->getGeneration();
+        renderer = Renderer(nw);
+        setAdaptive(false);
     }
 
     /**
-     * Function passed to each thread to compute the algorithm on the cells
+     * Saves the current generation in a snapshot file, each worker writing its
+     * own stripe of the table in parallel
      * 
-     * @param rows_start index of the first row assigned to this thread
-     * @param rows_stop index of the last row assigned to this thread
-     * @param width the number of cells in each row
+     * @param path path of the snapshot file
+     * @param ruleId identifier of the rule, stored in the snapshot
+     * @param encoding encoding of the cells, SNAPSHOT_INT32 or SNAPSHOT_UINT8
      */
-    void execute(int rows_start, int rows_stop, int width) {
-      for (int j = 0; j < nSteps; j++) {
-        for (int i = rows_start; i < rows_stop; i++) {
-          for (int j = 0; j < width; j++) {
+    void save(const char* path, uint32_t ruleId = 0, uint32_t encoding = SNAPSHOT_INT32) {
+      int fd = snapshotCreate(path, height, width, generation.load(), ruleId, encoding);
+      atomic<bool> ok(true);
+      vector<thread> tids;
+      for (int i = 0; i < nw; i++) {
+        tids.push_back(thread([&, i]() {
+          if (!snapshotWriteStripe(fd, encoding, table, bounds[i] * width, bounds[i + 1] * width)) ok = false;
+        }));
+      }
+      for (auto& t : tids) {
+        t.join();
+      }
+      close(fd);
+      if (!ok) throw "Cannot write the snapshot file";
+    }
+
+    /**
+     * Records the evolution from the current generation, which is written as the
+     * first keyframe. The recorder is owned by the caller and must have the same
+     * dimensions of the automaton
+     * 
+     * @param r the recorder, nullptr to stop recording
+     */
+    void setRecorder(DeltaRecorder* r) {
+      if (r != nullptr && (r->getHeight() != height || r->getWidth() != width)) {
+        throw "Invalid parameters, check framework API";
+      }
+      recorder = r;
+      if (recorder == nullptr) return;
+      recorder->setWorkers(nw);
+      recorder->keyframe(generation.load(), table);
+    }
+
+    /**
+     * Enables or disables the statistics of the generations: while computing a
+     * step each worker counts the live cells, births, deaths, bounding box and
+     * states of its stripe, and the counters are combined at the barrier into a
+     * time series, without further passes over the table. Enabling them starts
+     * a new series
+     * 
+     * @param enabled whether to reduce the statistics
+     * @param states number of states counted in the histograms
+     */
+    void setStats(bool enabled, int states = 2) {
+      if (states <= 0) {
+        throw "Invalid parameters, check framework API";
+      }
+      reducing = enabled;
+      if (reducing) reducer = StepReducer(nw, states);
+    }
+
+    /**
+     * Returns the statistics of the generations computed since setStats(true),
+     * one entry per generation
+     */
+    const vector<StepStats>& getStats() { return reducer.getSeries(); }
+
+    /**
+     * Enables or disables the population pyramid: while computing a step each
+     * worker counts the live cells of the blocks of its stripe, at the levels of
+     * the pyramid (see pyramid.hpp), the blocks shared with other workers being
+     * summed at the barrier
+     * 
+     * @param enabled whether to compute the pyramid
+     * @param depth number of levels, level k having blocks of side 8^(k + 1)
+     */
+    void setPyramid(bool enabled, int depth = 3) {
+      if (depth <= 0) {
+        throw "Invalid parameters, check framework API";
+      }
+      pyramiding = enabled;
+      if (pyramiding) pyramid = DensityPyramid(nw, height, width, depth);
+    }
+
+    /**
+     * Returns the population pyramid of the last generation computed, to be read
+     * between steps
+     */
+    DensityPyramid& getPyramid() { return pyramid; }
+
+    /**
+     * Enables or disables the tracking of the changes: while computing a step
+     * each worker counts the cells of its stripe changing state in every tile of
+     * 8x8 cells, in the same way as the population pyramid
+     * 
+     * @param enabled whether to count the changes
+     * @param depth number of levels of the counts, level k having tiles of side 8^(k + 1)
+     */
+    void setChangeTracking(bool enabled, int depth = 1) {
+      if (depth <= 0) {
+        throw "Invalid parameters, check framework API";
+      }
+      tracking = enabled;
+      if (tracking) changes = DensityPyramid(nw, height, width, depth);
+    }
+
+    /**
+     * Returns the counts of the cells of each tile which changed state in the
+     * last step, a tile being dirty when its count is not 0
+     */
+    DensityPyramid& getChanges() { return changes; }
+
+    /**
+     * Returns rectangles covering the tiles which changed in the last step
+     */
+    vector<DirtyRect> getDirtyRectangles() { return dirtyRectangles(changes, height, width); }
+
+    /**
+     * Enables or disables the detection of still lifes and oscillators. Every
+     * generation is hashed incrementally by the workers, which only hash the
+     * cells of their stripe changing state, and compared at the barrier with the
+     * last window generations (see cycles.hpp)
+     * 
+     * @param enabled whether to hash the generations
+     * @param window number of recent generations compared, i.e. the longest
+     * period detected
+     * @param stop whether run() stops at the first generation repeating a recent one
+     */
+    void setCycleDetection(bool enabled, int window = 64, bool stop = true) {
+      if (window <= 0) {
+        throw "Invalid parameters, check framework API";
+      }
+      detecting = enabled;
+      stopOnCycle = stop;
+      if (detecting) cycles = CycleDetector(nw, window);
+      hashStale = true;
+    }
+
+    /**
+     * Returns the period of the first cycle detected, 1 for a still life, 0 if
+     * no generation repeated a recent one
+     */
+    long getPeriod() { return cycles.getPeriod(); }
+
+    /**
+     * Returns the first generation found to repeat a recent one, -1 if none
+     */
+    long getRepeatedGeneration() { return cycles.getRepeatedGeneration(); }
+
+    /**
+     * Hashes the whole current generation, each worker hashing its own stripe,
+     * and restarts the history of the detector from it
+     */
+    void rehash() {
+      vector<uint64_t> partial(nw, 0);
+      vector<thread> tids;
+      for (int i = 0; i < nw; i++) {
+        tids.push_back(thread([&, i]() {
+          uint64_t h = 0;
+          for (long j = bounds[i] * width; j < bounds[i + 1] * width; j++) {
+            h += cellHash(j, table.getCellValue(j));
+          }
+          partial[i] = h;
+        }));
+      }
+      for (auto& t : tids) {
+        t.join();
+      }
+      uint64_t h = 0;
+      for (uint64_t p : partial) {
+        h += p;
+      }
+      cycles.reset(generation.load(), h);
+      hashStale = false;
+    }
+
+    /**
+     * Populates the matrix with random cells, alive with the given probability.
+     * Each worker generates its own stripe, so that its memory is first touched
+     * by the thread computing it, and the result only depends on the seed
+     * 
+     * @param seed seed of the counter-based generator
+     * @param density probability of a cell being alive
+     */
+    void generate(uint64_t seed, double density) {
+      // checked here, as the workers cannot report an invalid density
+      densityThreshold(density);
+      table.allocateRows();
+      vector<thread> tids;
+      for (int i = 0; i < nw; i++) {
+        tids.push_back(thread([&, i]() {
+          table.generate(seed, density, bounds[i], bounds[i + 1]);
+        }));
+      }
+      for (auto& t : tids) {
+        t.join();
+      }
+      hashStale = true;
+    }
+
+    /**
+     * Sets all the cells of the current generation to 0, each worker clearing
+     * its own stripe
+     */
+    void clear() {
+      vector<thread> tids;
+      for (int i = 0; i < nw; i++) {
+        tids.push_back(thread([&, i]() {
+          for (long r = bounds[i]; r < bounds[i + 1]; r++) {
+            for (long c = 0; c < width; c++) {
+              table.setCurrent(r, c, 0);
+            }
+          }
+        }));
+      }
+      for (auto& t : tids) {
+        t.join();
+      }
+      hashStale = true;
+    }
+
+    /**
+     * Places a pattern on the current generation, parsing it directly into the
+     * table, in parallel for large files. The pattern wraps around the edges of
+     * the board and only its live cells are written
+     * 
+     * @param path pattern file: Golly RLE (.rle), plaintext (.cells) or packed
+     * binary grid (see loaders.hpp)
+     * @param row row where the top left corner of the pattern is placed
+     * @param column column where the top left corner of the pattern is placed
+     */
+    void load(const char* path, long row = 0, long column = 0) {
+      loadPattern(path, row, column, nw, [this](long r, long c, int value) {
+        r %= height;
+        c %= width;
+        if (r < 0) r += height;
+        if (c < 0) c += width;
+        table.setCurrent(r, c, value);
+      });
+      hashStale = true;
+    }
+
+    /**
+     * Enables or disables the adaptive repartitioning of the stripes. When enabled,
+     * the compute time of each worker is measured at every step and, every period
+     * steps, the boundaries are moved toward balance if the slowest worker exceeds
+     * the average by more than threshold
+     *
+     * @param enabled whether to repartition the stripes
+     * @param period number of steps between two checks
+     * @param threshold relative imbalance tolerated before moving the boundaries
+     */
+    void setAdaptive(bool enabled, int period = 8, double threshold = 0.1) {
+      adaptive = enabled;
+      balancer = Balancer(nw, height, period, threshold);
+      bounds = balancer.evenBounds();
+    }
+
+    /**
+     * Returns the current boundaries of the stripes, worker i computing the
+     * rows in [bounds[i], bounds[i + 1])
+     */
+    vector<long> getBounds() { return bounds; }
+
+    /**
+     * Computes the rule on a stripe of rows
+     * 
+     * @param id index of the worker owning the stripe
+     * @param rows_start index of the first row of the stripe
+     * @param rows_stop index past the last row of the stripe
+     */
+    void sweep(int id, long rows_start, long rows_stop) {
+      if (capture != nullptr) {
+        for (long i = rows_start * width; i < rows_stop * width; i++) {
+          capture->cells[i] = table.getCellValue(i);
+        }
+      }
+      if (ringCells != nullptr) {
+        for (long i = rows_start * width; i < rows_stop * width; i++) {
+          ringCells[i] = (uint8_t) table.getCellValue(i);
+        }
+      }
+      // the plain loop of the framework when no feature works on the single cells
+      if (recorder == nullptr && !reducing && !detecting && !pyramiding && !tracking && metrics == nullptr) {
+        for (long i = rows_start; i < rows_stop; i++) {
+          for (long j = 0; j < width; j++) {
             int val = table.getCellValue(i, j);
             int nVal = rule(val, table.getNeighbours(i, j));
             table.setFuture(i, j, nVal);
           }
         }
+        return;
+      }
+      // the features are read once, so that the loop does not reload the members at every cell
+      const bool hashing = detecting;
+      const bool aggregating = pyramiding;
+      const bool marking = tracking;
+      const bool counting = metrics != nullptr;
+      DeltaEncoder* delta = recorder != nullptr ? &recorder->encoder(id) : nullptr;
+      if (delta != nullptr) delta->begin(rows_start * width, recorder->wantsKeyframe(generation.load() + 1));
+      WorkerStats* stats = reducing ? &reducer.worker(id) : nullptr;
+      if (stats != nullptr) stats->reset();
+      if (aggregating) pyramid.begin(id, rows_start * width, rows_stop * width);
+      if (marking) changes.begin(id, rows_start * width, rows_stop * width);
+      uint64_t hash = 0;
+      long live = 0;
+      for (long i = rows_start; i < rows_stop; i++) {
+        for (long j = 0; j < width; j++) {
+          int val = table.getCellValue(i, j);
+          int nVal = rule(val, table.getNeighbours(i, j));
+          table.setFuture(i, j, nVal);
+          if (delta != nullptr) delta->push((val != 0) != (nVal != 0), nVal != 0);
+          if (hashing && val != nVal) hash += cellHash(i * width + j, nVal) - cellHash(i * width + j, val);
+          if (stats != nullptr) stats->add(i, j, val, nVal);
+          if (aggregating) pyramid.add(id, i, j, nVal != 0);
+          if (marking) changes.add(id, i, j, val != nVal);
+          if (counting) live += nVal != 0;
+        }
+      }
+      if (aggregating) pyramid.end(id);
+      if (marking) changes.end(id);
+      if (delta != nullptr) delta->end();
+      if (hashing) cycles.tile(id) = hash;
+      if (counting) metrics->setLive(id, live);
+    }
+
+    /**
+     * Function passed to each thread to compute the algorithm on the cells
+     * 
+     * @param id index of the worker, its stripe of rows is read from bounds at every step
+     */
+    void execute(int id) {
+      for (int j = 0; j < nSteps; j++) {
+        if (counters != nullptr) counters->begin(id);
+        auto computeStart = Clock::now();
+        long gen = generation.load() + 1;
+        sweep(id, bounds[id], bounds[id + 1]);
+        auto computeEnd = adaptive || tracer != nullptr || metrics != nullptr ? Clock::now() : computeStart;
+        if (counters != nullptr) counters->end(id);
+        if (adaptive) {
+          balancer.record(id, chrono::duration_cast<chrono::microseconds>(computeEnd - computeStart).count());
+        }
         unique_lock<mutex> lock(m);
         if (++threadsReady == nw) {
           check.notify_all();
         }
-        nextStep.wait(lock);
+        nextStep.wait(lock, [&] { return released > j; });
+        if (tracer != nullptr || metrics != nullptr) {
+          lock.unlock();
+          auto releaseTime = Clock::now();
+          if (tracer != nullptr) {
+            tracer->record(id, TRACE_COMPUTE, gen, computeStart, computeEnd);
+            tracer->record(id, TRACE_BARRIER, gen, computeEnd, releaseTime);
+          }
+          if (metrics != nullptr) metrics->step(id, computeStart, computeEnd, releaseTime);
+        }
+        if (halt.load()) break;
       }
-      threadsDone++;
-      if (threadsDone.load() == nw) { check.notify_all(); }
+      unique_lock<mutex> lock(m);
+      if (++threadsDone == nw) { check.notify_all(); }
       return;
     }
+
+    /**
+     * Called once per step while the workers are waiting at the barrier: hands the
+     * captured generation to the stream and to the ring, queues the delta, reduces the
+     * statistics of the step, moves the stripe boundaries, swaps the future in,
+     * hashes the new generation and checks whether the run must stop
+     * 
+     * @returns true if the computation must stop at this generation
+     */
+    bool stepDone() {
+      if (capture != nullptr) {
+        stream->submit(capture);
+        capture = nullptr;
+      }
+      if (ringCells != nullptr) {
+        ring->end();
+        ringCells = nullptr;
+      }
+      if (recorder != nullptr) recorder->commit(generation.load() + 1, nw);
+      if (reducing) reducer.combine(generation.load() + 1, nw);
+      if (pyramiding) pyramid.combine(generation.load() + 1, nw);
+      if (tracking) changes.combine(generation.load() + 1, nw);
+      if (adaptive) balancer.rebalance(bounds);
+      auto swapStart = tracer != nullptr ? Clock::now() : Clock::time_point();
+      table.swapCurrentFuture();
+      if (tracer != nullptr) tracer->record(nw, TRACE_SWAP, generation.load() + 1, swapStart, Clock::now());
+      generation++;
+      if (metrics != nullptr) metrics->publish(generation.load());
+      startCapture();
+      bool stop = detecting && cycles.step(generation.load(), nw) && stopOnCycle;
+      if (control != nullptr && control->shouldStop(generation.load())) stop = true;
+      if (stream != nullptr && stream->getError() != nullptr) stop = true;
+      return stop;
+    }
+
+    /**
+     * If the current generation has to be streamed or published, takes a buffer
+     * or a slot of the ring in which the workers copy their stripes at the
+     * beginning of the next sweep
+     */
+    void startCapture() {
+      if (ring != nullptr && ringCells == nullptr && publishedGeneration != generation.load()
+          && ring->wants(generation.load())) {
+        ringCells = ring->begin(generation.load());
+        publishedGeneration = generation.load();
+      }
+      if (stream == nullptr || capture != nullptr || capturedGeneration == generation.load()) return;
+      if (stream->wants(generation.load())) {
+        capture = stream->acquire(generation.load());
+        capturedGeneration = generation.load();
+      }
+    }
+
+    /**
+     * Completes the capture of the last generation of a run, which will not be
+     * followed by a sweep
+     */
+    void finishCapture() {
+      if (ringCells != nullptr) {
+        for (long i = 0; i < size; i++) {
+          ringCells[i] = (uint8_t) table.getCellValue(i);
+        }
+        ring->end();
+        ringCells = nullptr;
+      }
+      if (capture == nullptr) return;
+      for (long i = 0; i < size; i++) {
+        capture->cells[i] = table.getCellValue(i);
+      }
+      stream->submit(capture);
+      capture = nullptr;
+    }
+
+    /**
+     * Streams every generation accepted by the given stream, starting from the
+     * current one. The stream is owned by the caller and must have the same
+     * dimensions of the automaton
+     * 
+     * @param s the output stage, nullptr to stop streaming
+     */
+    void setStream(GenerationStream* s) {
+      if (s != nullptr && (s->getHeight() != height || s->getWidth() != width)) {
+        throw "Invalid parameters, check framework API";
+      }
+      finishCapture();
+      stream = s;
+      capturedGeneration = -1;
+    }
+
+    /**
+     * Publishes every generation accepted by the given shared-memory ring,
+     * starting from the current one, for readers in other processes. The ring is
+     * owned by the caller and must have the same dimensions of the automaton
+     * 
+     * @param r the ring, nullptr to stop publishing
+     */
+    void setRing(ShmRing* r) {
+      if (r != nullptr && (r->getHeight() != height || r->getWidth() != width)) {
+        throw "Invalid parameters, check framework API";
+      }
+      finishCapture();
+      ring = r;
+      publishedGeneration = -1;
+    }
+
+    /**
+     * Records the timeline of the next runs in the given tracer (see trace.hpp).
+     * The tracer is owned by the caller and must have the same number of workers
+     * 
+     * @param t the tracer, nullptr to stop tracing
+     */
+    void setTracer(Tracer* t) {
+      if (t != nullptr && t->getWorkers() != nw) {
+        throw "Invalid parameters, check framework API";
+      }
+      tracer = t;
+    }
+
+    /**
+     * Counts the hardware events of the compute phases of the workers in the
+     * given counters (see perf_counters.hpp). The counters are owned by the caller
+     * and must have the same number of workers
+     * 
+     * @param c the counters, nullptr to stop counting
+     */
+    void setCounters(PerfCounters* c) {
+      if (c != nullptr && c->getWorkers() != nw) {
+        throw "Invalid parameters, check framework API";
+      }
+      counters = c;
+    }
+
+    /**
+     * Publishes the live metrics of the next runs in the given object (see
+     * metrics.hpp), which can be read by other threads while the Game is
+     * running. The metrics are owned by the caller and must have the same number
+     * of workers and of cells
+     * 
+     * @param l the metrics, nullptr to stop publishing
+     */
+    void setMetrics(LiveMetrics* l) {
+      if (l != nullptr && (l->getWorkers() != nw || l->getCells() != (long) height * width)) {
+        throw "Invalid parameters, check framework API";
+      }
+      metrics = l;
+    }
+
+    /**
+     * Returns a copy of the live metrics, from any thread and without stopping a
+     * run in progress, or empty metrics if they are not published
+     */
+    MetricsSnapshot getMetrics() {
+      LiveMetrics* l = metrics;
+      if (l != nullptr) return l->snapshot();
+      MetricsSnapshot empty = MetricsSnapshot();
+      empty.generation = generation.load();
+      empty.population = -1;
+      return empty;
+    }
     
     /**
      * Function containing the algorithm to use to compute the next state of a cell
@@ -135,70 +819,131 @@ class Game {
     virtual int rule(int val, vector<int> arr) { return 0; };
 
     /**
-     * Prints the current state of the automata
+     * Returns a read-only view over the current generation, reading the cells in
+     * the table without copying them. The view is valid until the next step
+     */
+    GridView view() { return table.view(); }
+
+    /**
+     * Returns a read-only view over a rectangle of the current generation
+     * 
+     * @param row first row of the rectangle
+     * @param column first column of the rectangle
+     * @param h number of rows of the rectangle
+     * @param w number of columns of the rectangle
+     */
+    GridView view(long row, long column, long h, long w) { return table.view().sub(row, column, h, w); }
+
+    /**
+     * Prints the current state of the automata, formatted in parallel by the
+     * workers and written at once
+     * 
+     * @param scale side of the blocks of cells printed as a single glyph
+     */
+    void print(long scale = 1) {
+      renderer.setScale(scale);
+      renderer.print(view());
+    }
+
+    /**
+     * Saves the current state of the automata as text or as an image
+     * 
+     * @param path path of the file
+     * @param format RENDER_TEXT, RENDER_PBM or RENDER_PGM (see render.hpp)
+     * @param scale side of the blocks of cells rendered as a single glyph or pixel
      */
-    void print() {
-      table.printCurrent();
+    void render(const char* path, int format, long scale = 1) {
+      renderer.setScale(scale);
+      renderer.save(path, view(), format);
     }
 
     /**
-     * Starts the computation of the automata
+     * Starts the computation of the automata. Only one run at a time can be in
+     * progress on a Game, synchronous or started with run_async. If the sink of
+     * the stream fails, the run stops at the next generation and throws its error
      * 
      * @param steps number of steps to be performed
      * @returns the overhead for parallel computation in microseconds
      */
     double run(int steps) {
+      bool expected = false;
+      if (!running.compare_exchange_strong(expected, true)) {
+        throw "A run is already in progress";
+      }
+      try {
+        double overhead = runSteps(steps);
+        if (stream != nullptr) stream->check();
+        running = false;
+        return overhead;
+      } catch (...) {
+        running = false;
+        throw;
+      }
+    }
+
+    /**
+     * Performs the steps of a run, once the Game is marked as running
+     * 
+     * @param steps number of steps to be performed
+     * @returns the overhead for parallel computation in microseconds
+     */
+    double runSteps(int steps) {
       nSteps = steps;
 
+      if (detecting && hashStale) rehash();
+      startCapture();
+
+      // a run cancelled or stopped before its first step performs none
+      if (control != nullptr && control->shouldStop(generation.load())) {
+        finishCapture();
+        return 0;
+      }
+
       if (nw == 1) {
         for (int j = 0; j < nSteps; j++) {
-          for (int i = 0; i < height; i++) {
-            for (int j = 0; j < width; j++) {
-              int val = table.getCellValue(i, j);
-              int nVal = rule(val, table.getNeighbours(i, j));
-              table.setFuture(i, j, nVal);
-            }
+          if (counters != nullptr) counters->begin(0);
+          auto computeStart = Clock::now();
+          sweep(0, 0, height);
+          auto computeEnd = Clock::now();
+          if (counters != nullptr) counters->end(0);
+          if (metrics != nullptr) metrics->step(0, computeStart, computeEnd, computeEnd);
+          bool stop = stepDone();
+          if (tracer != nullptr) {
+            tracer->record(0, TRACE_COMPUTE, generation.load(), computeStart, computeEnd);
+            tracer->record(1, TRACE_SERIAL, generation.load(), computeEnd, Clock::now());
           }
-          table.swapCurrentFuture();
+          if (stop) break;
         }
+        finishCapture();
         return 0;
       }
 
       auto startTime = Clock::now();
 
+      released = 0;
+      halt = false;
       vector<thread*> tids(nw);
-      long s_height = height / nw;   // actual height of the current subtable (including the last one)
-      long remaining  = height % nw;
-      long start = 0;
-      long stop = s_height;
       for(int i = 0; i < nw; i++) {
-        tids[i] = new thread(&Game::execute, this, start, stop, width);
-        start += s_height;
-        if (i == (nw - 2)) stop += s_height + remaining;
-        else stop += s_height;
+        tids[i] = new thread(&Game::execute, this, i);
       }
 
       auto endTime = Clock::now();
       auto setupTime = chrono::duration_cast<chrono::microseconds>(endTime - startTime).count();
 
       // if computation is not over
-      while (threadsDone.load() != nw) {
+      while (true) {
         // check if threads are all ready for the next step
         unique_lock<mutex> lock(m);
-        /* cout << "Threads done: " << threadsDone.load() << endl; */
-        while (threadsReady.load() < nw) {
-          //cout << threadsReady.load() << "=/=" << nw << endl;
-          check.wait(lock);
-          /* cout << "Woken up, tR: " << threadsReady.load() << "tD: " << threadsDone.load() << endl; */
-          if (threadsDone.load() == nw) break;
-        }
+        check.wait(lock, [&] { return threadsReady.load() == nw || threadsDone.load() == nw; });
         if (threadsDone.load() == nw) break;
         startTime = Clock::now();
-        table.swapCurrentFuture();
+        halt = stepDone();
         threadsReady.exchange(0);
+        released++;
         // send wake up signals
         nextStep.notify_all();
         endTime = Clock::now();
+        if (tracer != nullptr) tracer->record(nw, TRACE_SERIAL, generation.load(), startTime, endTime);
         setupTime = setupTime + chrono::duration_cast<chrono::microseconds>(endTime - startTime).count();
       }
 
@@ -207,10 +952,56 @@ class Game {
       threadsReady.exchange(0);
       threadsDone.exchange(0);
 
-      for(auto e : tids)
+      for(auto e : tids) {
         e->join();
+        delete e;
+      }
+      finishCapture();
 
       endTime = Clock::now();
       return setupTime + chrono::duration_cast<chrono::microseconds>(endTime - startTime).count();
     }
+
+    /**
+     * Starts the computation of the automata without blocking the caller. The run
+     * can be observed and cancelled through the returned handle, and stops at the
+     * first generation boundary where the time budget is exhausted or the stop
+     * predicate holds
+     * 
+     * @param steps number of steps to be performed
+     * @param budgetMs maximum duration of the run in milliseconds, 0 for no limit
+     * @param stopWhen predicate evaluated on the Game at every generation boundary
+     * @returns the handle of the run, whose result is the value returned by run()
+     */
+    RunHandle run_async(int steps, long budgetMs = 0, function<bool(Game&)> stopWhen = nullptr) {
+      bool expected = false;
+      if (!running.compare_exchange_strong(expected, true)) {
+        throw "A run is already in progress";
+      }
+      auto ctl = make_shared<RunControl>(generation.load(), steps, budgetMs);
+      if (stopWhen) ctl->stopWhen = [this, stopWhen]() { return stopWhen(*this); };
+      control = ctl.get();
+      shared_future<double> result = async(launch::async, [this, ctl, steps]() {
+        double overhead = 0;
+        try {
+          overhead = runSteps(steps);
+          if (stream != nullptr) stream->check();
+        } catch (...) {
+          control = nullptr;
+          running = false;
+          throw;
+        }
+        control = nullptr;
+        running = false;
+        return overhead;
+      }).share();
+      asyncControl = ctl;
+      asyncResult = result;
+      return RunHandle(ctl, result);
+    }
+
+    /**
+     * Returns the number of generations computed since the construction of the Game
+     */
+    long getGeneration() { return generation.load(); }
 };
\ No newline at end of file
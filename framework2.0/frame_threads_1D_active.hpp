@@ -16,8 +16,12 @@
 #include <cstdlib>
 #include <chrono>
 
+// Employ the cells table implementation
+#ifdef CELLS
+#include "cells_1D_t.hpp"
+#else
 #include "ints_1D_t.hpp"
-//#include "cells_1D_t.hpp"
+#endif
 
 using namespace std;
 
@@ -75,6 +79,7 @@ class Game {
           throw "Invalid parameters, check framework API";
         }
         table = Table(height, width);
+        table.generate();
         size = height * width;
         threadsReady = 0;
         threadsDone = 0;
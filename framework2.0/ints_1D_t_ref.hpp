@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cstdlib>
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -11,8 +12,8 @@ using namespace std;
  * @param b right-handside of the modulo operation
  * @returns the modulo operation from a and b
  */
-int mod(int a, int b) {
-  int r = a - (int) (a / b) * b;
+long mod(long a, long b) {
+  long r = a - (a / b) * b;
   return r < 0 ? (r + b) : r;
 }
 
@@ -25,8 +26,8 @@ class Table {
   private:
     int* current;
     int* future;
-    int width;
-    int height;
+    long width;
+    long height;
 
   public:
     // Default constructor
@@ -35,11 +36,11 @@ class Table {
     // Constructor initializing the table with random values
     Table(int height, int width):
       height(height), width(width) {
-      int size = height * width;
-      int column, row;
+      long size = (long) height * width;
+      long column, row;
       current = new int[size];
       future = new int[size];
-      for (int i = 0; i < size; i++) {
+      for (long i = 0; i < size; i++) {
         row = i / width;
         column = i % width;
         current[i] = rand() % 2;
@@ -50,11 +51,11 @@ class Table {
     // Constructor initializing the table with input values
     Table(int height, int width, vector<int> input):
       height(height), width(width) {
-      int size = height * width;
-      int column, row;
+      long size = (long) height * width;
+      long column, row;
       current = new int[size];
       future = new int[size];
-      for (int i = 0; i < size; i++) {
+      for (long i = 0; i < size; i++) {
         row = i / width;
         column = i % width;
         current[i] = input[i];
@@ -65,12 +66,12 @@ class Table {
     // Getters
     int* getCurrent() { return current; }
 
-    int getCellValue(int i) {
+    int getCellValue(long i) {
       return current[i];
     }
 
     // Setter
-    void setFuture(int index, int value) {
+    void setFuture(long index, int value) {
       future[index] = value;
     }
 
@@ -79,30 +80,34 @@ class Table {
      * Prints the current state of the matrix
      */
     void printCurrent() {
-      for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
+      string text;
+      text.reserve(height * (width + 1) + 1);
+      for (long i = 0; i < height; i++) {
+        for (long j = 0; j < width; j++) {
           int v = current[i * width + j];
-          if (v == 0) cout << "-";
-          else cout << "x";
+          text.push_back(v == 0 ? '-' : 'x');
         }
-        cout << endl;
+        text.push_back('\n');
       }
-      cout << endl;
+      text.push_back('\n');
+      cout.write(text.data(), text.size()).flush();
     }
 
     /**
      * Prints the next state of the matrix
      */
     void printFuture() {
-      for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
+      string text;
+      text.reserve(height * (width + 1) + 1);
+      for (long i = 0; i < height; i++) {
+        for (long j = 0; j < width; j++) {
           int v = future[i * width + j];
-          if (v == 0) cout << "-";
-          else cout << "x";
+          text.push_back(v == 0 ? '-' : 'x');
         }
-        cout << endl;
+        text.push_back('\n');
       }
-      cout << endl;
+      text.push_back('\n');
+      cout.write(text.data(), text.size()).flush();
     }
 
     /**
@@ -122,15 +127,15 @@ class Table {
      * @param i index of the cell in examination
      * @returns a vector containing the 8 values of the cell's neighbourhood
      */
-    vector<int> getNeighbours(int i) {
+    vector<int> getNeighbours(long i) {
       long column, row;
       row = i / width;
       column = i % width;
-      long x1 = width * (mod(row - 1, width));
-      long x2 = width * (mod(row + 1, width));
+      long x1 = width * (mod(row - 1, height));
+      long x2 = width * (mod(row + 1, height));
       long x3 = width * row;
-      long y1 = mod(column - 1, height);
-      long y2 = mod(column + 1, height);
+      long y1 = mod(column - 1, width);
+      long y2 = mod(column + 1, width);
       vector<int> arr = 
                 {
                 current[x1 + y1],  
@@ -145,15 +150,15 @@ class Table {
       return arr;
     }
 
-    void getNeighboursRef(int i, vector<int>* neighbours) {
+    void getNeighboursRef(long i, vector<int>* neighbours) {
       long column, row;
       row = i / width;
       column = i % width;
-      long x1 = width * (mod(row - 1, width));
-      long x2 = width * (mod(row + 1, width));
+      long x1 = width * (mod(row - 1, height));
+      long x2 = width * (mod(row + 1, height));
       long x3 = width * row;
-      long y1 = mod(column - 1, height);
-      long y2 = mod(column + 1, height);
+      long y1 = mod(column - 1, width);
+      long y2 = mod(column + 1, width);
      ( *neighbours)[0] = current[x1 + y1];  
      ( *neighbours)[1] = current[x1 + column]; 
      ( *neighbours)[2] = current[x1 + y2]; 
@@ -1,7 +1,11 @@
 #include <iostream>
 #include <cstdlib>
+#include <string>
 #include <vector>
 
+#include "random.hpp"
+#include "view.hpp"
+
 using namespace std;
 
 /**
@@ -11,8 +15,8 @@ using namespace std;
  * @param b right-handside of the modulo operation
  * @returns the modulo operation from a and b
  */
-int mod(int a, int b) {
-  int r = a - (int) (a / b) * b;
+long mod(long a, long b) {
+  long r = a - (a / b) * b;
   return r < 0 ? (r + b) : r;
 }
 
@@ -25,84 +29,131 @@ class Table {
   private:
     int* current;
     int* future;
-    int width;
-    int height;
+    long width;
+    long height;
 
   public:
     // Default constructor
     Table() {}
 
-    // Constructor initializing the table with random values
+    // Constructor, the cells must then be initialized with generate()
     Table(int height, int width):
       height(height), width(width) {
-      int size = height * width;
-      int column, row;
+      long size = (long) height * width;
+      // memory is not touched here, so that each page is placed by the thread generating it
       current = new int[size];
       future = new int[size];
-      for (int i = 0; i < size; i++) {
-        row = i / width;
-        column = i % width;
-        current[i] = rand() % 2;
-        future[i] = 0;
-      }
     }
 
     // Constructor initializing the table with input values
-    Table(int height, int width, vector<int> input):
+    Table(int height, int width, const vector<int>& input):
       height(height), width(width) {
-      int size = height * width;
-      int column, row;
+      long size = (long) height * width;
       current = new int[size];
       future = new int[size];
-      for (int i = 0; i < size; i++) {
-        row = i / width;
-        column = i % width;
+      for (long i = 0; i < size; i++) {
         current[i] = input[i];
         future[i] = 0;
       }
     }
 
+    // Constructor adopting the given buffer as current state, without copying it
+    Table(int height, int width, int* buffer):
+      height(height), width(width) {
+      long size = (long) height * width;
+      current = buffer;
+      future = new int[size];
+      for (long i = 0; i < size; i++) {
+        future[i] = 0;
+      }
+    }
+
+    /**
+     * Populate the matrix with random values cells
+     */
+    void generate() {
+      generate(rand(), 0.5, 0, height * width);
+    }
+
+    /**
+     * Populate a stripe of the matrix with random values cells. Each cell only
+     * depends on the seed and on its index, so stripes can be generated in
+     * parallel, each one by the thread that will compute it
+     * 
+     * @param seed seed of the generator
+     * @param density probability of a cell being alive
+     * @param start index of the first cell of the stripe
+     * @param stop index past the last cell of the stripe
+     */
+    void generate(uint64_t seed, double density, long start, long stop) {
+      uint64_t threshold = densityThreshold(density);
+      for (long i = start; i < stop; i++) {
+        current[i] = randomCell(seed, threshold, i);
+        future[i] = 0;
+      }
+    }
+
     // Getters
     int* getCurrent() { return current; }
 
-    int getCellValue(int i) {
+    int getCellValue(long i) {
       return current[i];
     }
 
-    // Setter
-    void setFuture(int index, int value) {
+    // Setters
+    void setFuture(long index, int value) {
       future[index] = value;
     }
 
+    void setCurrent(long index, int value) {
+      current[index] = value;
+    }
+
+
+    /**
+     * Returns a read-only view over the current state of the matrix, valid until
+     * the next swap
+     */
+    GridView view() {
+      GridView v(width, sizeof(int));
+      for (long i = 0; i < height; i++) {
+        v.addRow(current + i * width);
+      }
+      return v;
+    }
 
     /**
      * Prints the current state of the matrix
      */
     void printCurrent() {
-      for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
+      string text;
+      text.reserve(height * (width + 1) + 1);
+      for (long i = 0; i < height; i++) {
+        for (long j = 0; j < width; j++) {
           int v = current[i * width + j];
-          if (v == 0) cout << "-";
-          else cout << "x";
+          text.push_back(v == 0 ? '-' : 'x');
         }
-        cout << endl;
+        text.push_back('\n');
       }
-      cout << endl;
+      text.push_back('\n');
+      cout.write(text.data(), text.size()).flush();
     }
 
     /**
      * Prints the next state of the matrix
      */
     void printFuture() {
-      for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
+      string text;
+      text.reserve(height * (width + 1) + 1);
+      for (long i = 0; i < height; i++) {
+        for (long j = 0; j < width; j++) {
           int v = future[i * width + j];
-          if (v == 0) cout << "-";
-          else cout << "x";
+          text.push_back(v == 0 ? '-' : 'x');
         }
-        cout << endl;
+        text.push_back('\n');
       }
-      cout << endl;
+      text.push_back('\n');
+      cout.write(text.data(), text.size()).flush();
     }
 
     /**
@@ -122,15 +173,15 @@ class Table {
      * @param i index of the cell in examination
      * @returns a vector containing the 8 values of the cell's neighbourhood
      */
-    vector<int> getNeighbours(int i) {
+    vector<int> getNeighbours(long i) {
       long column, row;
       row = i / width;
       column = i % width;
-      long x1 = width * (mod(row - 1, width));
-      long x2 = width * (mod(row + 1, width));
+      long x1 = width * (mod(row - 1, height));
+      long x2 = width * (mod(row + 1, height));
       long x3 = width * row;
-      long y1 = mod(column - 1, height);
-      long y2 = mod(column + 1, height);
+      long y1 = mod(column - 1, width);
+      long y2 = mod(column + 1, width);
       vector<int> arr = 
                 {
                 current[x1 + y1],  
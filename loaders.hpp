@@ -0,0 +1,350 @@
+/**
+ * Loaders parsing patterns directly into the table of the Game, in parallel by
+ * chunks of the input file.
+ *
+ * Supported formats:
+ * - Golly RLE (.rle): b / . dead, o alive, A-X states 1-24, $ end of row, ! end
+ * - plaintext (.cells): ! comment lines, . dead, O or * alive
+ * - packed binary grid (any other extension): 8 bytes magic, height and width as
+ *   64 bits little endian integers, then one bit per cell, each row padded to a
+ *   whole byte
+ *
+ * Only the cells which are not dead are written, so that several patterns can be
+ * placed on the same board. The loaders receive a setter(row, column, value),
+ * called concurrently by different threads on different cells.
+ */
+#ifndef LOADERS_HPP
+#define LOADERS_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "byte_order.hpp"
+
+using namespace std;
+
+// identifies a packed binary grid
+const char GRID_MAGIC[8] = {'C', 'A', 'G', 'R', 'I', 'D', 0, 0};
+
+/**
+ * Class mapping a file read-only in memory
+ */
+class MappedFile {
+  private:
+    void* base;
+    size_t length;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+  public:
+    // Constructor
+    MappedFile(const char* path) {
+      int fd = open(path, O_RDONLY);
+      if (fd < 0) throw "Cannot open the pattern file";
+      struct stat st;
+      if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw "Cannot open the pattern file";
+      }
+      length = st.st_size;
+      base = nullptr;
+      if (length > 0) {
+        base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+          close(fd);
+          throw "Cannot map the pattern file";
+        }
+        madvise(base, length, MADV_SEQUENTIAL);
+      }
+      close(fd);
+    }
+
+    // Destructor
+    ~MappedFile() { if (base != nullptr) munmap(base, length); }
+
+    // Getters
+    const char* data() { return (const char*) base; }
+    size_t size() { return length; }
+};
+
+/**
+ * Runs body(i) for i in [0, n) on n threads
+ */
+template<class F>
+void forEachChunk(int n, F body) {
+  if (n == 1) {
+    body(0);
+    return;
+  }
+  vector<thread> tids;
+  for (int i = 0; i < n; i++) {
+    tids.push_back(thread(body, i));
+  }
+  for (auto& t : tids) {
+    t.join();
+  }
+}
+
+/**
+ * Loads a plaintext pattern
+ *
+ * @param data content of the file
+ * @param len length of the content
+ * @param row row of the board where the top left corner of the pattern is placed
+ * @param column column of the board where the top left corner of the pattern is placed
+ * @param nw number of threads parsing the file
+ * @param set setter of the cells of the board
+ */
+template<class F>
+void loadPlaintext(const char* data, size_t len, long row, long column, int nw, F set) {
+  // chunks start at the beginning of a line
+  vector<size_t> starts(nw + 1);
+  for (int i = 0; i <= nw; i++) {
+    size_t p = i == nw ? len : len / nw * i;
+    while (p > 0 && p < len && data[p - 1] != '\n') p++;
+    starts[i] = p;
+  }
+  // first pass: lines of the pattern in each chunk
+  vector<long> lines(nw + 1, 0);
+  forEachChunk(nw, [&](int c) {
+    long n = 0;
+    bool lineStart = true;
+    for (size_t p = starts[c]; p < starts[c + 1]; p++) {
+      if (lineStart && data[p] != '!') n++;
+      lineStart = data[p] == '\n';
+    }
+    lines[c + 1] = n;
+  });
+  for (int c = 0; c < nw; c++) {
+    lines[c + 1] += lines[c];
+  }
+  // second pass: each chunk knows the row of its first line
+  forEachChunk(nw, [&](int c) {
+    long r = row + lines[c] - 1;
+    long col = column;
+    bool lineStart = true;
+    bool comment = false;
+    for (size_t p = starts[c]; p < starts[c + 1]; p++) {
+      char ch = data[p];
+      if (lineStart) {
+        comment = ch == '!';
+        if (!comment) r++;
+        col = column;
+      }
+      lineStart = ch == '\n';
+      if (comment || lineStart) continue;
+      if (ch == 'O' || ch == '*') set(r, col, 1);
+      col++;
+    }
+  });
+}
+
+/**
+ * @returns true if the character ends a token of the RLE body
+ */
+inline bool rleTag(char ch) {
+  return ch == '$' || ch == '!' || ch == '.' || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+/**
+ * Loads a Golly RLE pattern
+ *
+ * @param data content of the file
+ * @param len length of the content
+ * @param row row of the board where the top left corner of the pattern is placed
+ * @param column column of the board where the top left corner of the pattern is placed
+ * @param nw number of threads parsing the file
+ * @param set setter of the cells of the board
+ */
+template<class F>
+void loadRLE(const char* data, size_t len, long row, long column, int nw, F set) {
+  // skip the comments and the header line "x = ..., y = ..."
+  size_t body = 0;
+  while (body < len) {
+    size_t eol = body;
+    while (eol < len && data[eol] != '\n') eol++;
+    bool header = data[body] == '#' || data[body] == 'x' || eol == body || data[body] == '\r';
+    if (!header) break;
+    body = eol + 1;
+  }
+  if (body > len) body = len;
+  const char* end = (const char*) memchr(data + body, '!', len - body);
+  len = end != nullptr ? end - data : len;
+
+  // chunks start right after a tag, never inside a run count
+  vector<size_t> starts(nw + 1);
+  for (int i = 0; i <= nw; i++) {
+    size_t p = i == nw ? len : body + (len - body) / nw * i;
+    while (p > body && p < len && !rleTag(data[p - 1])) p++;
+    starts[i] = p;
+  }
+
+  // first pass: movement of the cursor over each chunk, as rows advanced and
+  // final column (relative to the starting column when no row is advanced)
+  vector<long> dRows(nw, 0);
+  vector<long> dCols(nw, 0);
+  forEachChunk(nw, [&](int c) {
+    long count = 0;
+    for (size_t p = starts[c]; p < starts[c + 1]; p++) {
+      char ch = data[p];
+      if (ch >= '0' && ch <= '9') {
+        count = count * 10 + (ch - '0');
+        continue;
+      }
+      if (!rleTag(ch)) continue;
+      long n = count > 0 ? count : 1;
+      count = 0;
+      if (ch == '$') {
+        dRows[c] += n;
+        dCols[c] = 0;
+      }
+      else dCols[c] += n;
+    }
+  });
+  vector<long> rows(nw);
+  vector<long> cols(nw);
+  long cursorRow = 0;
+  long cursorCol = 0;
+  for (int c = 0; c < nw; c++) {
+    rows[c] = cursorRow;
+    cols[c] = cursorCol;
+    if (dRows[c] > 0) cursorCol = dCols[c];
+    else cursorCol += dCols[c];
+    cursorRow += dRows[c];
+  }
+
+  // second pass: each chunk knows where its cursor starts
+  forEachChunk(nw, [&](int c) {
+    long r = rows[c];
+    long col = cols[c];
+    long count = 0;
+    for (size_t p = starts[c]; p < starts[c + 1]; p++) {
+      char ch = data[p];
+      if (ch >= '0' && ch <= '9') {
+        count = count * 10 + (ch - '0');
+        continue;
+      }
+      if (!rleTag(ch)) continue;
+      long n = count > 0 ? count : 1;
+      count = 0;
+      if (ch == '$') {
+        r += n;
+        col = 0;
+        continue;
+      }
+      int value = 1;
+      if (ch == 'b' || ch == '.') value = 0;
+      else if (ch >= 'A' && ch <= 'X') value = ch - 'A' + 1;
+      if (value != 0) {
+        for (long k = 0; k < n; k++) {
+          set(row + r, column + col + k, value);
+        }
+      }
+      col += n;
+    }
+  });
+}
+
+/**
+ * Loads a packed binary grid
+ *
+ * @param data content of the file
+ * @param len length of the content
+ * @param row row of the board where the top left corner of the grid is placed
+ * @param column column of the board where the top left corner of the grid is placed
+ * @param nw number of threads parsing the file
+ * @param set setter of the cells of the board
+ */
+template<class F>
+void loadPackedGrid(const char* data, size_t len, long row, long column, int nw, F set) {
+  if (len < 24 || memcmp(data, GRID_MAGIC, sizeof(GRID_MAGIC)) != 0) {
+    throw "Invalid grid file";
+  }
+  uint64_t h = getLittleEndian((const uint8_t*) data + 8, 8);
+  uint64_t w = getLittleEndian((const uint8_t*) data + 16, 8);
+  if (h > INT_MAX || w > INT_MAX) throw "Invalid grid file";
+  long height = h;
+  long width = w;
+  long rowBytes = (width + 7) / 8;
+  if (rowBytes > 0 && (uint64_t) height > (len - 24) / rowBytes) throw "Truncated grid file";
+  const uint8_t* bits = (const uint8_t*) data + 24;
+  forEachChunk(nw, [&](int c) {
+    long first = height / nw * c;
+    long last = c == nw - 1 ? height : height / nw * (c + 1);
+    for (long i = first; i < last; i++) {
+      const uint8_t* line = bits + i * rowBytes;
+      for (long b = 0; b < rowBytes; b++) {
+        if (line[b] == 0) continue;
+        for (int k = 0; k < 8 && b * 8 + k < width; k++) {
+          if (line[b] >> k & 1) set(row + i, column + b * 8 + k, 1);
+        }
+      }
+    }
+  });
+}
+
+/**
+ * Writes a packed binary grid
+ *
+ * @param path path of the grid file
+ * @param height number of rows
+ * @param width number of columns
+ * @param get getter(row, column) of the cells, a cell is alive when not 0
+ */
+template<class F>
+void savePackedGrid(const char* path, long height, long width, F get) {
+  if (height < 0 || width < 0 || height > INT_MAX || width > INT_MAX) {
+    throw "Invalid parameters, check framework API";
+  }
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) throw "Cannot create the grid file";
+  vector<uint8_t> header(GRID_MAGIC, GRID_MAGIC + sizeof(GRID_MAGIC));
+  putLittleEndian(header, height, 8);
+  putLittleEndian(header, width, 8);
+  bool written = fwrite(header.data(), 1, header.size(), file) == header.size();
+  vector<uint8_t> line((width + 7) / 8);
+  for (long i = 0; i < height && written; i++) {
+    fill(line.begin(), line.end(), 0);
+    for (long j = 0; j < width; j++) {
+      if (get(i, j) != 0) line[j / 8] |= 1 << (j % 8);
+    }
+    written = fwrite(line.data(), 1, line.size(), file) == line.size();
+  }
+  if (fclose(file) != 0 || !written) throw "Cannot write the grid file";
+}
+
+/**
+ * Loads a pattern choosing the format from the extension of the file
+ *
+ * @param path path of the pattern: .rle, .cells, or a packed binary grid
+ * @param row row of the board where the top left corner of the pattern is placed
+ * @param column column of the board where the top left corner of the pattern is placed
+ * @param nw number of threads parsing the file
+ * @param set setter of the cells of the board
+ */
+template<class F>
+void loadPattern(const char* path, long row, long column, int nw, F set) {
+  MappedFile file(path);
+  // small files are not worth the threads
+  if (file.size() < (size_t) nw * (1 << 16)) nw = 1;
+  string name(path);
+  auto endsWith = [&](const string& ext) {
+    return name.size() >= ext.size() && name.compare(name.size() - ext.size(), ext.size(), ext) == 0;
+  };
+  if (endsWith(".rle")) loadRLE(file.data(), file.size(), row, column, nw, set);
+  else if (endsWith(".cells")) loadPlaintext(file.data(), file.size(), row, column, nw, set);
+  else loadPackedGrid(file.data(), file.size(), row, column, nw, set);
+}
+
+#endif
@@ -0,0 +1,338 @@
+/**
+ * Live metrics of the runs of the std::thread frameworks, readable at any time
+ * by other threads without stopping the engine, and optionally served on a
+ * UNIX-domain socket in the Prometheus text exposition format.
+ *
+ * Every worker adds the time spent computing its stripe and waiting at the
+ * barrier to its own counters, and stores the live cells of its stripe; the
+ * thread coordinating the steps publishes at every generation the generation,
+ * the population and, once per window, the generations per second and the busy
+ * ratio of each worker over the window. The published values are protected by a
+ * sequence lock: the writer never waits, and readers retry the copy if a
+ * generation was published meanwhile.
+ */
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * Copy of the live metrics at a point in time
+ */
+struct MetricsSnapshot {
+  // last generation computed
+  long generation;
+  // generations per second over the last window, 0 before the first one ends
+  double generationsPerSecond;
+  // cells updated per second over the last window
+  double cellsPerSecond;
+  // live cells of the last generation computed, -1 if none was computed
+  long population;
+  // seconds since the metrics were attached and since the last generation
+  double uptime;
+  double idle;
+  // per-worker seconds spent computing and waiting at the barrier
+  vector<double> busySeconds;
+  vector<double> waitSeconds;
+  // per-worker fraction of the last window spent computing
+  vector<double> busyRatio;
+};
+
+/**
+ * Class holding the live metrics of a Game
+ */
+class LiveMetrics {
+  private:
+    typedef chrono::high_resolution_clock MetricsClock;
+
+    /**
+     * Counters of a worker
+     */
+    struct Worker {
+      atomic<int64_t> busy;
+      atomic<int64_t> wait;
+      atomic<long> live;
+      // busy ratio over the last window, published by the coordinator
+      atomic<double> ratio;
+      // keeps the counters of different workers on different cache lines
+      char padding[64];
+    };
+    int nw;
+    long cells;
+    int64_t window;
+    vector<Worker> workers;
+    MetricsClock::time_point origin;
+    // odd while the coordinator is publishing
+    atomic<uint64_t> sequence;
+    atomic<long> generation;
+    atomic<double> rate;
+    atomic<long> population;
+    atomic<int64_t> updated;
+    // start of the current window, only accessed by the coordinator
+    int64_t windowStart;
+    long windowGeneration;
+    vector<int64_t> windowBusy;
+    vector<int64_t> windowWait;
+
+    LiveMetrics(const LiveMetrics&) = delete;
+    LiveMetrics& operator=(const LiveMetrics&) = delete;
+
+    int64_t now() {
+      return chrono::duration_cast<chrono::nanoseconds>(MetricsClock::now() - origin).count();
+    }
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param nw number of workers of the Game
+     * @param cells number of cells of the Game
+     * @param window seconds over which the rates are measured
+     */
+    LiveMetrics(int nw, long cells, double window = 1.0):
+      nw(nw), cells(cells), window((int64_t) (window * 1e9)), workers(nw), windowBusy(nw), windowWait(nw) {
+      if (nw <= 0 || cells <= 0 || window <= 0) throw "Invalid parameters, check framework API";
+      for (auto& w : workers) {
+        w.busy = 0;
+        w.wait = 0;
+        w.live = 0;
+        w.ratio = 0;
+      }
+      origin = MetricsClock::now();
+      sequence = 0;
+      generation = 0;
+      rate = 0;
+      population = -1;
+      updated = 0;
+      windowStart = -1;
+      windowGeneration = 0;
+    }
+
+    /**
+     * Adds a step of a worker, called by the worker itself after its release
+     *
+     * @param id index of the worker
+     * @param computeStart start of the computation of its stripe
+     * @param computeEnd end of the computation and arrival at the barrier
+     * @param release release from the barrier
+     */
+    template<class TimePoint>
+    void step(int id, TimePoint computeStart, TimePoint computeEnd, TimePoint release) {
+      Worker& w = workers[id];
+      w.busy.fetch_add(chrono::duration_cast<chrono::nanoseconds>(computeEnd - computeStart).count(),
+                       memory_order_relaxed);
+      w.wait.fetch_add(chrono::duration_cast<chrono::nanoseconds>(release - computeEnd).count(),
+                       memory_order_relaxed);
+    }
+
+    /**
+     * Stores the live cells computed by a worker in its stripe, before the barrier
+     */
+    void setLive(int id, long live) { workers[id].live.store(live, memory_order_relaxed); }
+
+    /**
+     * Publishes a generation, called by the coordinator at the barrier
+     *
+     * @param gen the generation just computed
+     */
+    void publish(long gen) {
+      int64_t t = now();
+      long live = 0;
+      for (auto& w : workers) {
+        live += w.live.load(memory_order_relaxed);
+      }
+      bool closing = windowStart >= 0 && t - windowStart >= window;
+      uint64_t s = sequence.load(memory_order_relaxed);
+      sequence.store(s + 1, memory_order_relaxed);
+      atomic_thread_fence(memory_order_release);
+      generation.store(gen, memory_order_relaxed);
+      population.store(live, memory_order_relaxed);
+      updated.store(t, memory_order_relaxed);
+      if (closing) {
+        rate.store((gen - windowGeneration) * 1e9 / (t - windowStart), memory_order_relaxed);
+        for (int i = 0; i < nw; i++) {
+          int64_t busy = workers[i].busy.load(memory_order_relaxed) - windowBusy[i];
+          int64_t wait = workers[i].wait.load(memory_order_relaxed) - windowWait[i];
+          workers[i].ratio.store(busy + wait > 0 ? (double) busy / (busy + wait) : 0, memory_order_relaxed);
+        }
+      }
+      sequence.store(s + 2, memory_order_release);
+      if (windowStart < 0 || closing) {
+        windowStart = t;
+        windowGeneration = gen;
+        for (int i = 0; i < nw; i++) {
+          windowBusy[i] = workers[i].busy.load(memory_order_relaxed);
+          windowWait[i] = workers[i].wait.load(memory_order_relaxed);
+        }
+      }
+    }
+
+    /**
+     * Copies the metrics, from any thread and while the Game is running
+     */
+    MetricsSnapshot snapshot() {
+      MetricsSnapshot snap;
+      snap.busySeconds = vector<double>(nw);
+      snap.waitSeconds = vector<double>(nw);
+      snap.busyRatio = vector<double>(nw);
+      int64_t last;
+      uint64_t before, after;
+      do {
+        before = sequence.load(memory_order_acquire);
+        if (before & 1) continue;
+        snap.generation = generation.load(memory_order_relaxed);
+        snap.generationsPerSecond = rate.load(memory_order_relaxed);
+        snap.population = population.load(memory_order_relaxed);
+        last = updated.load(memory_order_relaxed);
+        for (int i = 0; i < nw; i++) {
+          snap.busyRatio[i] = workers[i].ratio.load(memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        after = sequence.load(memory_order_relaxed);
+      } while ((before & 1) || before != after);
+      for (int i = 0; i < nw; i++) {
+        snap.busySeconds[i] = workers[i].busy.load(memory_order_relaxed) / 1e9;
+        snap.waitSeconds[i] = workers[i].wait.load(memory_order_relaxed) / 1e9;
+      }
+      int64_t t = now();
+      snap.cellsPerSecond = snap.generationsPerSecond * cells;
+      snap.uptime = t / 1e9;
+      snap.idle = (t - last) / 1e9;
+      return snap;
+    }
+
+    // Getters
+    int getWorkers() { return nw; }
+    long getCells() { return cells; }
+};
+
+/**
+ * Formats a snapshot in the Prometheus text exposition format
+ *
+ * @param prefix prefix of the names of the metrics
+ */
+inline string prometheusText(const MetricsSnapshot& snap, const string& prefix = "life") {
+  stringstream out;
+  auto metric = [&](const string& name, const char* type, const char* help) {
+    out << "# HELP " << prefix << "_" << name << " " << help << "\n";
+    out << "# TYPE " << prefix << "_" << name << " " << type << "\n";
+  };
+  auto perWorker = [&](const string& name, const vector<double>& values) {
+    for (size_t i = 0; i < values.size(); i++) {
+      out << prefix << "_" << name << "{worker=\"" << i << "\"} " << values[i] << "\n";
+    }
+  };
+  metric("generations_total", "counter", "Generations computed by the Game.");
+  out << prefix << "_generations_total " << snap.generation << "\n";
+  metric("generations_per_second", "gauge", "Generations per second over the last window.");
+  out << prefix << "_generations_per_second " << snap.generationsPerSecond << "\n";
+  metric("cells_per_second", "gauge", "Cells updated per second over the last window.");
+  out << prefix << "_cells_per_second " << snap.cellsPerSecond << "\n";
+  if (snap.population >= 0) {
+    metric("population", "gauge", "Live cells of the last generation computed.");
+    out << prefix << "_population " << snap.population << "\n";
+  }
+  metric("idle_seconds", "gauge", "Seconds since the last generation was computed.");
+  out << prefix << "_idle_seconds " << snap.idle << "\n";
+  metric("worker_busy_seconds_total", "counter", "Seconds spent by a worker computing its stripe.");
+  perWorker("worker_busy_seconds_total", snap.busySeconds);
+  metric("worker_wait_seconds_total", "counter", "Seconds spent by a worker waiting at the barrier.");
+  perWorker("worker_wait_seconds_total", snap.waitSeconds);
+  metric("worker_busy_ratio", "gauge", "Fraction of the last window spent by a worker computing.");
+  perWorker("worker_busy_ratio", snap.busyRatio);
+  return out.str();
+}
+
+/**
+ * Class serving the metrics on a UNIX-domain socket, from a thread of its own.
+ * Every connection receives the current metrics as an HTTP response in the
+ * Prometheus text format, e.g.
+ *   curl --unix-socket /tmp/life.sock http://localhost/metrics
+ */
+class MetricsServer {
+  private:
+    string path;
+    int fd;
+    atomic<bool> stopping;
+    thread server;
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    void serve(function<MetricsSnapshot()> source, string prefix) {
+      while (!stopping.load()) {
+        pollfd listening = {fd, POLLIN, 0};
+        if (poll(&listening, 1, 100) <= 0) continue;
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0) continue;
+        // drains the request, if the client sends one
+        pollfd request = {client, POLLIN, 0};
+        char buffer[1024];
+        if (poll(&request, 1, 100) > 0) {
+          ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+          (void) n;
+        }
+        string body = prometheusText(source(), prefix);
+        string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                          + to_string(body.size()) + "\r\n\r\n" + body;
+        for (size_t sent = 0; sent < response.size();) {
+          ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+          if (n <= 0) break;
+          sent += n;
+        }
+        close(client);
+      }
+    }
+
+  public:
+    /**
+     * Constructor, starting to serve the metrics
+     *
+     * @param path path of the socket, replaced if it exists
+     * @param source function returning the current metrics, e.g. the getMetrics()
+     * of a Game
+     * @param prefix prefix of the names of the metrics
+     */
+    MetricsServer(const string& path, function<MetricsSnapshot()> source, const string& prefix = "life"):
+      path(path), stopping(false) {
+      sockaddr_un address;
+      memset(&address, 0, sizeof(address));
+      address.sun_family = AF_UNIX;
+      if (path.empty() || path.size() >= sizeof(address.sun_path)) throw "Invalid parameters, check framework API";
+      strcpy(address.sun_path, path.c_str());
+      fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (fd < 0) throw "Cannot create the metrics socket";
+      unlink(path.c_str());
+      if (::bind(fd, (sockaddr*) &address, sizeof(address)) < 0 || listen(fd, 8) < 0) {
+        close(fd);
+        throw "Cannot bind the metrics socket";
+      }
+      server = thread(&MetricsServer::serve, this, source, prefix);
+    }
+
+    /**
+     * Destructor, stopping the server and removing the socket
+     */
+    ~MetricsServer() {
+      stopping = true;
+      server.join();
+      close(fd);
+      unlink(path.c_str());
+    }
+};
+
+#endif
@@ -69,6 +69,7 @@ class Game {
     Game(int height, int width, int nw, int nSteps):
       nw(nw), nSteps(nSteps) {
         table = Table(height, width);
+        table.generate();
         size = height * width;
         threadsReady = 0;
         threadsDone = 0;
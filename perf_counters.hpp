@@ -0,0 +1,208 @@
+/**
+ * Per-thread hardware performance counters read through perf_event_open, to
+ * tell whether a configuration is compute, latency or bandwidth bound.
+ *
+ * Each worker opens its own counters, counting only the user space of its
+ * thread, and accumulates them around the compute phase of every step. The
+ * counters are opened lazily by the thread which uses them, and opened again if
+ * a new thread takes the place of the worker (the std::thread frameworks start
+ * new threads at every run, whose ids may be reused). A counter which cannot
+ * be opened (no PMU in a virtual machine, perf_event_paranoid, seccomp) is
+ * simply reported as not available, and the run goes on unaffected; counters
+ * multiplexed by the kernel are scaled by the fraction of time they were
+ * running.
+ */
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * Event to be counted
+ */
+struct PerfEvent {
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+};
+
+/**
+ * @returns the default events: cycles, instructions, LLC misses, dTLB misses
+ * and branch misses
+ */
+inline vector<PerfEvent> defaultPerfEvents() {
+  return {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"dtlb_misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+  };
+}
+
+/**
+ * Class holding the counters of the workers of a Game
+ */
+class PerfCounters {
+  private:
+    vector<PerfEvent> events;
+
+    /**
+     * Counters of a worker
+     */
+    struct Worker {
+      // token of the thread which opened the counters, 0 if none
+      uint64_t thread;
+      // descriptor of each event, -1 if not available
+      vector<int> fds;
+      // values at the beginning of the current compute phase
+      vector<double> started;
+      // accumulated values
+      vector<double> totals;
+      // keeps the counters of different workers on different cache lines
+      char padding[64];
+    };
+    vector<Worker> workers;
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    static void closeAll(Worker& w) {
+      for (auto& fd : w.fds) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+      }
+      w.thread = 0;
+    }
+
+    // unique token of the calling thread, never reused
+    static uint64_t threadToken() {
+      static atomic<uint64_t> next(1);
+      static thread_local uint64_t token = next++;
+      return token;
+    }
+
+    // opens the counters of the calling thread
+    void open(Worker& w, uint64_t thread) {
+      closeAll(w);
+      w.thread = thread;
+      for (size_t e = 0; e < events.size(); e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[e].type;
+        attr.config = events[e].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        w.fds[e] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      }
+    }
+
+    // reads the value of a counter, scaled if it was multiplexed
+    static double value(int fd) {
+      uint64_t data[3];
+      if (read(fd, data, sizeof(data)) != sizeof(data)) return 0;
+      if (data[2] == 0) return 0;
+      return data[2] < data[1] ? data[0] * ((double) data[1] / data[2]) : data[0];
+    }
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param nw number of workers of the Game
+     * @param events events counted by every worker
+     */
+    PerfCounters(int nw, const vector<PerfEvent>& events = defaultPerfEvents()): events(events) {
+      if (nw <= 0 || events.empty()) throw "Invalid parameters, check framework API";
+      workers = vector<Worker>(nw);
+      for (auto& w : workers) {
+        w.thread = 0;
+        w.fds = vector<int>(events.size(), -1);
+        w.started = vector<double>(events.size(), 0);
+        w.totals = vector<double>(events.size(), 0);
+      }
+    }
+
+    // Destructor
+    ~PerfCounters() {
+      for (auto& w : workers) closeAll(w);
+    }
+
+    // Getters
+    int getWorkers() { return workers.size(); }
+    int getEvents() { return events.size(); }
+    const char* getName(int event) { return events[event].name; }
+
+    /**
+     * @returns true if the given event could be counted by every worker which
+     * counted something
+     */
+    bool isAvailable(int event) {
+      bool any = false;
+      for (auto& w : workers) {
+        if (w.thread == 0) continue;
+        if (w.fds[event] < 0) return false;
+        any = true;
+      }
+      return any;
+    }
+
+    /**
+     * Starts a compute phase of a worker, called by its thread
+     */
+    void begin(int id) {
+      Worker& w = workers[id];
+      uint64_t thread = threadToken();
+      if (w.thread != thread) open(w, thread);
+      for (size_t e = 0; e < events.size(); e++) {
+        if (w.fds[e] >= 0) w.started[e] = value(w.fds[e]);
+      }
+    }
+
+    /**
+     * Ends a compute phase of a worker, accumulating the counted events
+     */
+    void end(int id) {
+      Worker& w = workers[id];
+      for (size_t e = 0; e < events.size(); e++) {
+        if (w.fds[e] >= 0) w.totals[e] += value(w.fds[e]) - w.started[e];
+      }
+    }
+
+    /**
+     * @returns the value of an event accumulated by a worker
+     */
+    double get(int id, int event) { return workers[id].totals[event]; }
+
+    /**
+     * @returns the value of an event accumulated by all the workers
+     */
+    double total(int event) {
+      double sum = 0;
+      for (auto& w : workers) sum += w.totals[event];
+      return sum;
+    }
+
+    /**
+     * Discards the accumulated values
+     */
+    void reset() {
+      for (auto& w : workers) {
+        fill(w.totals.begin(), w.totals.end(), 0);
+      }
+    }
+};
+
+#endif
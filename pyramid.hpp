@@ -0,0 +1,212 @@
+/**
+ * Multi-resolution population pyramid of the generations, produced while the
+ * workers compute them.
+ *
+ * Level k of the pyramid counts the live cells of each block of side
+ * 8^(k + 1) cells (8x8, 64x64, 512x512 by default), blocks at the bottom and
+ * right edges being smaller. Each worker counts the level 0 blocks of the cells
+ * it writes and adds up its finished blocks into the coarser levels, so that the
+ * pyramid costs no extra pass over the table. The block rows entirely inside the
+ * stripe of a worker are written by it directly, the few ones shared with the
+ * neighbouring stripes are summed at the barrier. A cell is alive when its value
+ * is not 0.
+ *
+ * The same counters can count any other property of the cells, such as having
+ * changed state in the last step (see changes.hpp).
+ */
+#ifndef PYRAMID_HPP
+#define PYRAMID_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Counts of a block row shared by more than one worker
+ */
+struct PyramidEdge {
+  int level;
+  long blockRow;
+  vector<uint32_t> counts;
+};
+
+/**
+ * Class representing the pyramid and the counters of the workers
+ */
+class DensityPyramid {
+  private:
+    long height;
+    long width;
+    // side of the blocks of each level
+    vector<long> sides;
+    // columns of blocks of each level
+    vector<long> columns;
+    // row-major counts of each level
+    vector<vector<uint32_t>> levels;
+    // generation described by the counts
+    long generation;
+
+    /**
+     * Counters of a worker
+     */
+    struct Worker {
+      // index of the first cell and past the last cell of the stripe
+      long start;
+      long stop;
+      // block row being counted at each level, -1 if none
+      vector<long> blockRows;
+      // counts of the block row being counted at each level
+      vector<vector<uint32_t>> pending;
+      // shared block rows completed during the sweep
+      vector<PyramidEdge> edges;
+      // keeps the counters of different workers on different cache lines
+      char padding[64];
+    };
+    vector<Worker> workers;
+
+    // moves the pending counts of a level to the pyramid, or to the edges of the
+    // worker if the block row is not entirely in its stripe, and into the level above
+    void flush(Worker& w, int level) {
+      long blockRow = w.blockRows[level];
+      if (blockRow < 0) return;
+      vector<uint32_t>& counts = w.pending[level];
+      long firstRow = blockRow * sides[level];
+      long lastRow = min(firstRow + sides[level], height);
+      if (w.start <= firstRow * width && w.stop >= lastRow * width) {
+        copy(counts.begin(), counts.end(), levels[level].begin() + blockRow * columns[level]);
+      }
+      else w.edges.push_back({level, blockRow, counts});
+      if (level + 1 < (int) levels.size()) {
+        long upper = firstRow / sides[level + 1];
+        if (w.blockRows[level + 1] != upper) {
+          flush(w, level + 1);
+          w.blockRows[level + 1] = upper;
+        }
+        vector<uint32_t>& above = w.pending[level + 1];
+        for (long c = 0; c < columns[level]; c++) {
+          above[c / 8] += counts[c];
+        }
+      }
+      fill(counts.begin(), counts.end(), 0);
+      w.blockRows[level] = -1;
+    }
+
+  public:
+    // Default constructor, an empty pyramid
+    DensityPyramid(): height(0), width(0), generation(-1) {}
+
+    /**
+     * Constructor
+     *
+     * @param nw number of workers
+     * @param height number of rows of the automaton
+     * @param width number of columns of the automaton
+     * @param depth number of levels, level k having blocks of side 8^(k + 1)
+     */
+    DensityPyramid(int nw, long height, long width, int depth = 3):
+      height(height), width(width) {
+        long side = 8;
+        for (int k = 0; k < depth; k++) {
+          sides.push_back(side);
+          columns.push_back((width + side - 1) / side);
+          levels.push_back(vector<uint32_t>((height + side - 1) / side * columns[k], 0));
+          side *= 8;
+        }
+        workers = vector<Worker>(nw);
+        for (auto& w : workers) {
+          w.blockRows = vector<long>(depth, -1);
+          for (int k = 0; k < depth; k++) {
+            w.pending.push_back(vector<uint32_t>(columns[k], 0));
+          }
+        }
+        generation = -1;
+    }
+
+    /**
+     * Starts the counting of a stripe by a worker
+     *
+     * @param id index of the worker
+     * @param start index of the first cell of the stripe
+     * @param stop index past the last cell of the stripe
+     */
+    void begin(int id, long start, long stop) {
+      Worker& w = workers[id];
+      w.start = start;
+      w.stop = stop;
+      w.edges.clear();
+    }
+
+    /**
+     * Accounts for a cell of the future generation, cells being visited in
+     * row-major order
+     *
+     * @param id index of the worker
+     * @param row row of the cell
+     * @param column column of the cell
+     * @param alive whether the cell is alive
+     */
+    void add(int id, long row, long column, bool alive) {
+      Worker& w = workers[id];
+      long blockRow = row >> 3;
+      if (w.blockRows[0] != blockRow) {
+        flush(w, 0);
+        w.blockRows[0] = blockRow;
+      }
+      w.pending[0][column >> 3] += alive;
+    }
+
+    /**
+     * Completes the counting of the stripe of a worker
+     */
+    void end(int id) {
+      Worker& w = workers[id];
+      for (int k = 0; k < (int) levels.size(); k++) {
+        flush(w, k);
+      }
+    }
+
+    /**
+     * Sums the block rows shared by the first nw workers, completing the pyramid
+     *
+     * @param gen generation counted by the workers
+     * @param nw number of workers which swept a stripe
+     */
+    void combine(long gen, int nw) {
+      for (int i = 0; i < nw; i++) {
+        for (auto& e : workers[i].edges) {
+          auto first = levels[e.level].begin() + e.blockRow * columns[e.level];
+          fill(first, first + columns[e.level], 0);
+        }
+      }
+      for (int i = 0; i < nw; i++) {
+        for (auto& e : workers[i].edges) {
+          uint32_t* counts = levels[e.level].data() + e.blockRow * columns[e.level];
+          for (long c = 0; c < columns[e.level]; c++) {
+            counts[c] += e.counts[c];
+          }
+        }
+      }
+      generation = gen;
+    }
+
+    // Getters
+    int getDepth() { return levels.size(); }
+    long getGeneration() { return generation; }
+    // side of the blocks of the given level
+    long getSide(int level) { return sides[level]; }
+    long getRows(int level) { return levels[level].size() / columns[level]; }
+    long getColumns(int level) { return columns[level]; }
+    // row-major counts of the live cells of the blocks of the given level
+    const vector<uint32_t>& getLevel(int level) { return levels[level]; }
+
+    /**
+     * @returns the number of live cells in the given block of the given level
+     */
+    uint32_t getCount(int level, long blockRow, long blockColumn) {
+      return levels[level][blockRow * columns[level] + blockColumn];
+    }
+};
+
+#endif
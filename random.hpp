@@ -0,0 +1,56 @@
+/**
+ * Counter-based random generator used to initialize the tables.
+ *
+ * The random value of a cell only depends on the seed and on the index of the
+ * cell, so the table can be filled in parallel by any number of threads, in any
+ * order, always obtaining the same cells.
+ */
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+/**
+ * SplitMix64 finalizer, a bijective mixing of the 64 bits of x
+ */
+inline uint64_t mix64(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * Returns the index-th value of the SplitMix64 sequence started from seed,
+ * i.e. the generator jumped ahead by index steps
+ *
+ * @param seed seed of the sequence
+ * @param index position in the sequence
+ * @returns 64 random bits
+ */
+inline uint64_t counterRandom(uint64_t seed, uint64_t index) {
+  return mix64(mix64(seed) + (index + 1) * 0x9e3779b97f4a7c15ULL);
+}
+
+/**
+ * Converts a probability into a threshold for counterRandom
+ *
+ * @param density probability of a cell being alive, in [0, 1]
+ * @returns the threshold below which a random value means alive, UINT64_MAX
+ * meaning always alive
+ */
+inline uint64_t densityThreshold(double density) {
+  if (!(density >= 0 && density <= 1)) throw "Invalid parameters, check framework API";
+  double scaled = density * 18446744073709551616.0;
+  // densities just below 1 round to 2^64, which does not fit in the threshold
+  if (scaled >= 18446744073709551616.0) return UINT64_MAX;
+  return (uint64_t) scaled;
+}
+
+/**
+ * @returns 1 if the cell with the given index is alive, 0 otherwise
+ */
+inline int randomCell(uint64_t seed, uint64_t threshold, uint64_t index) {
+  return threshold == UINT64_MAX || counterRandom(seed, index) < threshold;
+}
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * Statistics of the generations reduced while the workers compute them.
+ *
+ * Every worker accumulates, while writing the future of its stripe, the number
+ * of live cells, births and deaths, the bounding box of the live cells and the
+ * histogram of the states into its own counters. The counters are combined once
+ * per step at the barrier, so that no extra pass over the table and no shared
+ * write is needed. The counters of each worker, histogram included, lie on
+ * cache lines of their own, so that the workers do not falsely share them. A
+ * cell is alive when its value is not 0.
+ */
+#ifndef REDUCTIONS_HPP
+#define REDUCTIONS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Statistics of a generation
+ */
+struct StepStats {
+  // generation the statistics refer to
+  long generation;
+  // number of live cells
+  long population;
+  // number of cells which became alive in this generation
+  long births;
+  // number of cells which died in this generation
+  long deaths;
+  // bounding box of the live cells, all -1 when there are none
+  long minRow;
+  long maxRow;
+  long minColumn;
+  long maxColumn;
+  // number of cells in each state, states out of range are not counted
+  vector<long> histogram;
+};
+
+/**
+ * Counters owned by a single worker
+ */
+struct WorkerStats {
+  long population;
+  long births;
+  long deaths;
+  long minRow;
+  long maxRow;
+  long minColumn;
+  long maxColumn;
+  // number of cells in each of the first states, in the cache lines of the worker
+  long* histogram;
+  int states;
+  // keeps the counters of different workers on different cache lines
+  char padding[64];
+
+  /**
+   * Resets the counters at the beginning of a sweep
+   */
+  void reset() {
+    population = 0;
+    births = 0;
+    deaths = 0;
+    minRow = -1;
+    maxRow = -1;
+    minColumn = -1;
+    maxColumn = -1;
+    fill(histogram, histogram + states, 0);
+  }
+
+  /**
+   * Accounts for a cell of the stripe
+   *
+   * @param row row of the cell
+   * @param column column of the cell
+   * @param val state of the cell in the current generation
+   * @param nVal state of the cell in the future generation
+   */
+  void add(long row, long column, int val, int nVal) {
+    if ((unsigned) nVal < (unsigned) states) histogram[nVal]++;
+    if (nVal == 0) {
+      if (val != 0) deaths++;
+      return;
+    }
+    if (val == 0) births++;
+    if (population++ == 0) {
+      minRow = maxRow = row;
+      minColumn = maxColumn = column;
+      return;
+    }
+    // cells are visited in row-major order, the first row cannot decrease
+    maxRow = row;
+    if (column < minColumn) minColumn = column;
+    if (column > maxColumn) maxColumn = column;
+  }
+};
+
+/**
+ * Class combining the counters of the workers into a time series
+ */
+class StepReducer {
+  private:
+    // number of states counted in the histograms
+    int states;
+    vector<WorkerStats> workers;
+    // histograms of the workers, each one starting on a cache line of its own
+    vector<long> counts;
+    // statistics of the generations computed since the reducer was enabled
+    vector<StepStats> series;
+
+    /**
+     * Points the workers to their histograms, in the cache-line aligned blocks
+     * of counts
+     */
+    void bind() {
+      // longs in a cache line, the block of a worker being a whole number of lines
+      const long line = 64 / sizeof(long);
+      long stride = (states + line - 1) / line * line;
+      counts.assign(workers.size() * stride + line, 0);
+      uintptr_t address = (uintptr_t) counts.data();
+      long* base = (long*) ((address + 63) / 64 * 64);
+      for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].histogram = base + i * stride;
+        workers[i].states = states;
+      }
+    }
+
+  public:
+    // Default constructor
+    StepReducer(): states(0) {}
+
+    // Constructor
+    StepReducer(int nw, int states): states(states) {
+      workers = vector<WorkerStats>(nw);
+      bind();
+      for (auto& w : workers) {
+        w.reset();
+      }
+    }
+
+    // Copy constructor, the copy owning its histograms
+    StepReducer(const StepReducer& obj) { *this = obj; }
+
+    // Copy assignment, the copy owning its histograms
+    StepReducer& operator=(const StepReducer& obj) {
+      if (this == &obj) return *this;
+      states = obj.states;
+      workers = obj.workers;
+      series = obj.series;
+      bind();
+      for (size_t i = 0; i < workers.size(); i++) {
+        copy(obj.workers[i].histogram, obj.workers[i].histogram + states, workers[i].histogram);
+      }
+      return *this;
+    }
+
+    /**
+     * @returns the counters of the given worker
+     */
+    WorkerStats& worker(int id) { return workers[id]; }
+
+    /**
+     * Combines the counters of the first nw workers, appending the statistics
+     * of the given generation to the series
+     *
+     * @param generation generation computed by the workers
+     * @param nw number of workers which swept a stripe
+     */
+    void combine(long generation, int nw) {
+      StepStats s;
+      s.generation = generation;
+      s.population = 0;
+      s.births = 0;
+      s.deaths = 0;
+      s.minRow = s.maxRow = s.minColumn = s.maxColumn = -1;
+      s.histogram = vector<long>(states, 0);
+      for (int i = 0; i < nw; i++) {
+        WorkerStats& w = workers[i];
+        s.births += w.births;
+        s.deaths += w.deaths;
+        for (int k = 0; k < states; k++) {
+          s.histogram[k] += w.histogram[k];
+        }
+        if (w.population == 0) continue;
+        if (s.population == 0) {
+          s.minRow = w.minRow;
+          s.maxRow = w.maxRow;
+          s.minColumn = w.minColumn;
+          s.maxColumn = w.maxColumn;
+        }
+        else {
+          s.minRow = min(s.minRow, w.minRow);
+          s.maxRow = max(s.maxRow, w.maxRow);
+          s.minColumn = min(s.minColumn, w.minColumn);
+          s.maxColumn = max(s.maxColumn, w.maxColumn);
+        }
+        s.population += w.population;
+      }
+      series.push_back(s);
+    }
+
+    // Getters
+    int getStates() { return states; }
+    const vector<StepStats>& getSeries() { return series; }
+};
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ * Performance regression tracking: a flat-file database of benchmark results,
+ * and the comparison of the results of a build against a stored baseline.
+ *
+ * The database is a directory holding one subdirectory per host, named by its
+ * fingerprint (host name and a hash of the CPU model and of the number of
+ * cores), with one file per revision of the code, named by the git revision.
+ * Each line of a file is one run, "configuration,time_us", runs being appended
+ * so that repeated sessions accumulate samples. Results are only compared on the
+ * same host.
+ *
+ * A configuration is flagged as a regression when the whole bootstrap
+ * confidence interval of the ratio between the current and the baseline median
+ * times (see sampling.hpp) lies above 1 + tolerance, and as an improvement when
+ * it lies below 1 - tolerance.
+ */
+#ifndef REGRESSIONS_HPP
+#define REGRESSIONS_HPP
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "random.hpp"
+#include "sampling.hpp"
+
+using namespace std;
+
+/**
+ * Time of a run of a configuration
+ */
+struct RunRecord {
+  // engine and parameters of the run, without commas
+  string configuration;
+  // duration of the run in microseconds
+  double time;
+};
+
+/**
+ * Comparison of a configuration between the baseline and the current results
+ */
+struct Comparison {
+  string configuration;
+  long baselineRuns;
+  long currentRuns;
+  double baselineMedian;
+  double currentMedian;
+  // current over baseline median time, with its confidence interval
+  Interval ratio;
+  // whether both sides have enough runs to be compared
+  bool comparable;
+  bool regression;
+  bool improvement;
+};
+
+/**
+ * Replaces the characters which are not safe in a file name
+ */
+inline string safeName(const string& name) {
+  string safe;
+  for (char ch : name) {
+    safe += isalnum((unsigned char) ch) || ch == '-' || ch == '_' || ch == '.' ? ch : '_';
+  }
+  return safe.empty() || safe[0] == '.' ? "_" + safe : safe;
+}
+
+/**
+ * @returns the fingerprint of the host: its name and a hash of the CPU model and
+ * of the number of cores
+ */
+inline string hostFingerprint() {
+  char name[256] = {0};
+  gethostname(name, sizeof(name) - 1);
+  string model;
+  ifstream cpuinfo("/proc/cpuinfo");
+  string line;
+  while (getline(cpuinfo, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      model = line.substr(line.find(':') + 1);
+      break;
+    }
+  }
+  string description = model + "/" + to_string(thread::hardware_concurrency());
+  uint64_t hash = 0;
+  for (char ch : description) hash = mix64(hash ^ (unsigned char) ch);
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) hash);
+  return safeName(string(name) + "-" + string(hex).substr(0, 12));
+}
+
+/**
+ * @returns the git revision of the working directory, marked dirty if it has
+ * uncommitted changes, or "unknown" outside of a repository
+ */
+inline string gitRevision() {
+  FILE* git = popen("git describe --always --dirty 2>/dev/null", "r");
+  if (git == nullptr) return "unknown";
+  char buffer[128] = {0};
+  string revision = fgets(buffer, sizeof(buffer), git) != nullptr ? buffer : "";
+  pclose(git);
+  while (!revision.empty() && isspace((unsigned char) revision.back())) revision.pop_back();
+  return revision.empty() ? "unknown" : safeName(revision);
+}
+
+/**
+ * Class storing and loading the results in the database directory
+ */
+class ResultsDatabase {
+  private:
+    string dir;
+
+    string path(const string& host, const string& revision) {
+      return dir + "/" + safeName(host) + "/" + safeName(revision) + ".csv";
+    }
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param dir directory of the database, created when results are saved
+     */
+    ResultsDatabase(const string& dir): dir(dir) {}
+
+    /**
+     * Appends runs to the results of a revision on a host
+     */
+    void save(const string& host, const string& revision, const vector<RunRecord>& runs) {
+      mkdir(dir.c_str(), 0755);
+      mkdir((dir + "/" + safeName(host)).c_str(), 0755);
+      ofstream out(path(host, revision), ios::app);
+      if (!out) throw "Cannot open the results database";
+      for (auto& r : runs) {
+        out << r.configuration << "," << r.time << "\n";
+      }
+      if (!out.flush()) throw "Cannot write the results database";
+    }
+
+    /**
+     * Loads the runs of a revision on a host
+     */
+    vector<RunRecord> load(const string& host, const string& revision) {
+      ifstream in(path(host, revision));
+      if (!in) throw "No stored results for the revision on this host";
+      vector<RunRecord> runs;
+      string line;
+      while (getline(in, line)) {
+        size_t comma = line.rfind(',');
+        if (comma == string::npos) continue;
+        runs.push_back({line.substr(0, comma), atof(line.c_str() + comma + 1)});
+      }
+      return runs;
+    }
+};
+
+/**
+ * Compares the configurations present in both sets of runs
+ *
+ * @param baseline runs of the baseline
+ * @param current runs to be checked
+ * @param tolerance relative slowdown or speedup which is not flagged
+ * @param level confidence level of the intervals
+ * @returns the comparison of each configuration, in the order of the current runs
+ */
+inline vector<Comparison> compareRuns(const vector<RunRecord>& baseline, const vector<RunRecord>& current,
+                                      double tolerance = 0.05, double level = 0.95) {
+  map<string, vector<double>> before;
+  for (auto& r : baseline) before[r.configuration].push_back(r.time);
+  map<string, vector<double>> after;
+  vector<string> order;
+  for (auto& r : current) {
+    if (after.find(r.configuration) == after.end()) order.push_back(r.configuration);
+    after[r.configuration].push_back(r.time);
+  }
+  vector<Comparison> comparisons;
+  for (auto& configuration : order) {
+    auto b = before.find(configuration);
+    if (b == before.end()) continue;
+    vector<double>& a = after[configuration];
+    Comparison c;
+    c.configuration = configuration;
+    c.baselineRuns = b->second.size();
+    c.currentRuns = a.size();
+    c.baselineMedian = summarize(b->second).median;
+    c.currentMedian = summarize(a).median;
+    c.comparable = c.baselineRuns >= 3 && c.currentRuns >= 3;
+    c.ratio = bootstrapRatio(a, b->second, level);
+    c.regression = c.comparable && c.ratio.low > 1 + tolerance;
+    c.improvement = c.comparable && c.ratio.high < 1 - tolerance;
+    comparisons.push_back(c);
+  }
+  return comparisons;
+}
+
+#endif
@@ -0,0 +1,169 @@
+/**
+ * Renderer formatting a generation into a preallocated buffer, in parallel by
+ * stripes of output rows, then emitting it with a single write.
+ *
+ * The generation can be downsampled, each glyph or pixel summarizing a block of
+ * scale x scale cells, and rendered as:
+ * - text, with the glyphs used by print(): '-' for a dead block, 'x' for a block
+ *   with at least one live cell
+ * - binary PBM (P4), black for a block with at least one live cell
+ * - binary PGM (P5), darker as the fraction of live cells in the block grows
+ */
+#ifndef RENDER_HPP
+#define RENDER_HPP
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "view.hpp"
+
+using namespace std;
+
+// formats of the renderer
+const int RENDER_TEXT = 0;
+const int RENDER_PBM = 1;
+const int RENDER_PGM = 2;
+
+/**
+ * Class rendering views of the table, reusing its buffer between calls
+ */
+class Renderer {
+  private:
+    // number of threads formatting the rows
+    int nw;
+    // side of the block of cells summarized by a glyph or pixel
+    long scale;
+    vector<char> buffer;
+
+    // number of live cells in the block of the given output row and column, and
+    // number of cells of the block (smaller at the bottom and right edges)
+    long countAlive(const GridView& view, long r, long c, long& cells) {
+      long rowStop = min((r + 1) * scale, view.getHeight());
+      long colStop = min((c + 1) * scale, view.getWidth());
+      long alive = 0;
+      for (long i = r * scale; i < rowStop; i++) {
+        for (long j = c * scale; j < colStop; j++) {
+          alive += view(i, j) != 0;
+        }
+      }
+      cells = (rowStop - r * scale) * (colStop - c * scale);
+      return alive;
+    }
+
+    // formats the output rows, body(r, line) writing row r at line
+    template<class F>
+    void formatRows(long rows, long header, long lineLength, F body) {
+      int n = rows < nw ? (rows > 0 ? rows : 1) : nw;
+      // small outputs are not worth the threads
+      if (rows * lineLength < (1 << 16)) n = 1;
+      vector<thread> tids;
+      for (int t = 0; t < n; t++) {
+        tids.push_back(thread([&, t]() {
+          long first = rows / n * t;
+          long last = t == n - 1 ? rows : rows / n * (t + 1);
+          for (long r = first; r < last; r++) {
+            body(r, buffer.data() + header + r * lineLength);
+          }
+        }));
+      }
+      for (auto& t : tids) {
+        t.join();
+      }
+    }
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param nw number of threads formatting the output
+     * @param scale side of the block of cells summarized by a glyph or pixel
+     */
+    Renderer(int nw = 1, long scale = 1): nw(nw), scale(scale) {
+      if (nw <= 0 || scale <= 0) {
+        throw "Invalid parameters, check framework API";
+      }
+    }
+
+    // Getters
+    int getWorkers() { return nw; }
+    long getScale() { return scale; }
+
+    // Setters
+    void setScale(long s) {
+      if (s <= 0) throw "Invalid parameters, check framework API";
+      scale = s;
+    }
+
+    /**
+     * Renders a view in the given format
+     *
+     * @param view the cells to render
+     * @param format one of RENDER_TEXT, RENDER_PBM, RENDER_PGM
+     * @returns the rendered bytes, valid until the next call
+     */
+    const vector<char>& render(const GridView& view, int format) {
+      long rows = (view.getHeight() + scale - 1) / scale;
+      long columns = (view.getWidth() + scale - 1) / scale;
+      string header;
+      long lineLength;
+      if (format == RENDER_TEXT) lineLength = columns + 1;
+      else if (format == RENDER_PBM) {
+        header = "P4\n" + to_string(columns) + " " + to_string(rows) + "\n";
+        lineLength = (columns + 7) / 8;
+      }
+      else if (format == RENDER_PGM) {
+        header = "P5\n" + to_string(columns) + " " + to_string(rows) + "\n255\n";
+        lineLength = columns;
+      }
+      else throw "Unknown render format";
+
+      // text ends with an empty line, as print()
+      buffer.resize(header.size() + rows * lineLength + (format == RENDER_TEXT));
+      copy(header.begin(), header.end(), buffer.begin());
+      formatRows(rows, header.size(), lineLength, [&](long r, char* line) {
+        long cells;
+        for (long c = 0; c < columns; c++) {
+          long alive = countAlive(view, r, c, cells);
+          if (format == RENDER_TEXT) line[c] = alive == 0 ? '-' : 'x';
+          else if (format == RENDER_PGM) line[c] = (char) (255 - alive * 255 / cells);
+          else {
+            if (c % 8 == 0) line[c / 8] = 0;
+            if (alive > 0) line[c / 8] |= 0x80 >> (c % 8);
+          }
+        }
+        if (format == RENDER_TEXT) line[columns] = '\n';
+      });
+      if (format == RENDER_TEXT) buffer.back() = '\n';
+      return buffer;
+    }
+
+    /**
+     * Prints a view as text with a single write
+     */
+    void print(const GridView& view, ostream& out = cout) {
+      auto& text = render(view, RENDER_TEXT);
+      out.write(text.data(), text.size()).flush();
+    }
+
+    /**
+     * Writes a view in a file with a single write
+     *
+     * @param path path of the file
+     * @param view the cells to render
+     * @param format one of RENDER_TEXT, RENDER_PBM, RENDER_PGM
+     */
+    void save(const char* path, const GridView& view, int format) {
+      auto& bytes = render(view, format);
+      FILE* file = fopen(path, "wb");
+      if (file == nullptr) throw "Cannot create the image file";
+      bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+      if (fclose(file) != 0 || !ok) throw "Cannot write the image file";
+    }
+};
+
+#endif
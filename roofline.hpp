@@ -0,0 +1,163 @@
+/**
+ * Roofline model of the machine, to tell how far a run of an engine is from the
+ * throughput the machine can attain on a grid.
+ *
+ * Two ceilings are measured at startup:
+ * - the memory bandwidth, with a STREAM triad (a[i] = b[i] + s * c[i]) over
+ *   arrays much larger than the caches, counting 3 arrays of traffic as STREAM
+ * - the compute peak of a core, as the cells per second updated by a tight Game
+ *   of Life kernel on a grid resident in the L1 cache
+ * A run updating cells of b bytes touches at least two buffers per generation,
+ * reading the current table and writing the future one, so its attainable
+ * throughput is the minimum between cores * peak and bandwidth / (2 * b) cells
+ * per second.
+ */
+#ifndef ROOFLINE_HPP
+#define ROOFLINE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Ceilings of the machine
+ */
+struct MachineRoof {
+  // bytes per second moved by the STREAM triad
+  double bandwidth;
+  // cells per second updated by a single core
+  double cellPeak;
+  // threads employed to measure the bandwidth
+  int threads;
+};
+
+/**
+ * Position of a run with respect to the roofline
+ */
+struct RooflinePoint {
+  // bytes per second moved by the run, at two buffers per generation
+  double bytesPerSecond;
+  // cells per second attainable by the run
+  double attainable;
+  // achieved over attainable cells per second
+  double fraction;
+  // whether the attainable throughput is limited by the bandwidth
+  bool memoryBound;
+};
+
+/**
+ * Measures the memory bandwidth with a STREAM triad
+ *
+ * @param threads number of threads, each one touching first its part of the arrays
+ * @param elements number of doubles of each of the 3 arrays
+ * @param repeats number of timed triads, the best one being taken
+ * @returns bytes per second
+ */
+inline double streamBandwidth(int threads, long elements = 1 << 23, int repeats = 5) {
+  if (threads <= 0 || elements <= 0 || repeats <= 0) throw "Invalid parameters, check framework API";
+  vector<double> a(elements), b(elements), c(elements);
+  auto parallel = [&](function<void(long, long)> work) {
+    vector<thread> tids;
+    for (int t = 0; t < threads; t++) {
+      tids.push_back(thread(work, elements * t / threads, elements * (t + 1) / threads));
+    }
+    for (auto& t : tids) t.join();
+  };
+  parallel([&](long start, long stop) {
+    for (long i = start; i < stop; i++) {
+      a[i] = 0;
+      b[i] = 1;
+      c[i] = 2;
+    }
+  });
+  double best = 0;
+  for (int r = 0; r < repeats; r++) {
+    auto startTime = chrono::high_resolution_clock::now();
+    parallel([&](long start, long stop) {
+      double* pa = a.data();
+      const double* pb = b.data();
+      const double* pc = c.data();
+      for (long i = start; i < stop; i++) {
+        pa[i] = pb[i] + 3.0 * pc[i];
+      }
+    });
+    auto endTime = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(endTime - startTime).count();
+    if (seconds > 0) best = max(best, 3.0 * sizeof(double) * elements / seconds);
+  }
+  return best;
+}
+
+/**
+ * Measures the cells per second a single core updates with a tight Game of
+ * Life kernel on a grid resident in the L1 cache
+ *
+ * @param side side of the grid
+ * @param generations number of timed generations
+ */
+inline double cellComputePeak(long side = 64, int generations = 2000) {
+  if (side < 3 || generations <= 0) throw "Invalid parameters, check framework API";
+  vector<int> current(side * side), future(side * side, 0);
+  for (long i = 0; i < side * side; i++) {
+    current[i] = (i * 2654435761u >> 13) & 1;
+  }
+  auto startTime = chrono::high_resolution_clock::now();
+  for (int g = 0; g < generations; g++) {
+    const int* in = current.data();
+    int* out = future.data();
+    for (long r = 1; r < side - 1; r++) {
+      for (long c = 1; c < side - 1; c++) {
+        const int* p = in + r * side + c;
+        int sum = p[-side - 1] + p[-side] + p[-side + 1] + p[-1] + p[1] + p[side - 1] + p[side] + p[side + 1];
+        out[r * side + c] = sum == 3 || (sum == 2 && *p == 1);
+      }
+    }
+    swap(current, future);
+  }
+  auto endTime = chrono::high_resolution_clock::now();
+  // keeps the kernel from being optimized away
+  volatile int sink = current[side + 1];
+  (void) sink;
+  double seconds = chrono::duration<double>(endTime - startTime).count();
+  return seconds > 0 ? (side - 2) * (side - 2) * (double) generations / seconds : 0;
+}
+
+/**
+ * Measures the ceilings of the machine
+ *
+ * @param threads number of threads employed to measure the bandwidth
+ */
+inline MachineRoof calibrateRoof(int threads) {
+  MachineRoof roof;
+  roof.bandwidth = streamBandwidth(threads);
+  roof.cellPeak = cellComputePeak();
+  roof.threads = threads;
+  return roof;
+}
+
+/**
+ * Places a run on the roofline
+ *
+ * @param roof ceilings of the machine
+ * @param cellsPerSecond cells per second updated by the run
+ * @param bytesPerCell bytes of a cell in the table of the engine
+ * @param nw number of workers of the run
+ */
+inline RooflinePoint rooflinePoint(const MachineRoof& roof, double cellsPerSecond, double bytesPerCell, int nw) {
+  long cores = thread::hardware_concurrency() > 0 ? thread::hardware_concurrency() : 1;
+  double traffic = 2 * bytesPerCell;
+  double compute = roof.cellPeak * min((long) nw, cores);
+  double memory = roof.bandwidth / traffic;
+  RooflinePoint p;
+  p.bytesPerSecond = cellsPerSecond * traffic;
+  p.attainable = min(compute, memory);
+  p.fraction = p.attainable > 0 ? cellsPerSecond / p.attainable : 0;
+  p.memoryBound = memory < compute;
+  return p;
+}
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * Utilities to run the automaton asynchronously: the Game checks a RunControl
+ * at every generation boundary, while the caller observes and steers the run
+ * through a RunHandle.
+ */
+#ifndef RUN_CONTROL_HPP
+#define RUN_CONTROL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+
+using namespace std;
+
+/**
+ * Class containing the state shared between an asynchronous run and its handle
+ */
+class RunControl {
+  public:
+    // set by the caller to stop the run at the next generation boundary
+    atomic<bool> cancelled;
+    // last generation completed by the Game
+    atomic<long> generation;
+    // generation of the Game when the run was started
+    long startGeneration;
+    // number of steps requested
+    int steps;
+    // whether the run stopped before performing all the steps
+    atomic<bool> stopped;
+    // whether a time budget was given
+    bool hasDeadline;
+    // time after which the run is stopped at the next generation boundary
+    chrono::steady_clock::time_point deadline;
+    // predicate evaluated at every generation boundary, the run stops when true
+    function<bool()> stopWhen;
+
+    // Constructor
+    RunControl(long startGeneration, int steps, long budgetMs):
+      startGeneration(startGeneration), steps(steps) {
+        cancelled = false;
+        stopped = false;
+        generation = startGeneration;
+        hasDeadline = budgetMs > 0;
+        deadline = chrono::steady_clock::now() + chrono::milliseconds(budgetMs);
+    }
+
+    /**
+     * Called by the Game at every generation boundary, while the workers are waiting
+     *
+     * @param gen the generation just completed
+     * @returns true if the run must stop at this generation
+     */
+    bool shouldStop(long gen) {
+      generation = gen;
+      bool stop = cancelled.load()
+                  || (hasDeadline && chrono::steady_clock::now() >= deadline)
+                  || (stopWhen && stopWhen());
+      if (stop && gen - startGeneration < steps) stopped = true;
+      return stop;
+    }
+};
+
+/**
+ * Class representing a run started with run_async
+ *
+ * Exposes the progress of the run, allows to cancel it and to wait for its result
+ */
+class RunHandle {
+  private:
+    shared_ptr<RunControl> control;
+    shared_future<double> result;
+
+  public:
+    // Default constructor
+    RunHandle() {}
+
+    // Constructor
+    RunHandle(shared_ptr<RunControl> control, shared_future<double> result):
+      control(control), result(result) {}
+
+    // Getters
+    long generation() { return control->generation.load(); }
+    long stepsDone() { return control->generation.load() - control->startGeneration; }
+    double progress() { return control->steps > 0 ? (double) stepsDone() / control->steps : 1; }
+
+    /**
+     * Requests the run to stop at the next generation boundary
+     */
+    void cancel() { control->cancelled = true; }
+
+    /**
+     * @returns true if the run is over
+     */
+    bool done() {
+      return result.wait_for(chrono::seconds(0)) == future_status::ready;
+    }
+
+    /**
+     * @returns true if the run was stopped by cancellation, time budget or predicate
+     */
+    bool stoppedEarly() {
+      wait();
+      return control->stopped.load();
+    }
+
+    /**
+     * Waits for the end of the run
+     */
+    void wait() { result.wait(); }
+
+    /**
+     * Waits for the end of the run, at most ms milliseconds
+     *
+     * @returns true if the run is over
+     */
+    bool waitFor(long ms) {
+      return result.wait_for(chrono::milliseconds(ms)) == future_status::ready;
+    }
+
+    /**
+     * Waits for the end of the run
+     *
+     * @returns the value returned by run(), rethrowing its exceptions if any
+     */
+    double get() { return result.get(); }
+};
+
+#endif
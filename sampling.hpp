@@ -0,0 +1,129 @@
+/**
+ * Statistics of repeated timing samples, used by the benchmarks.
+ *
+ * Timings are skewed by the occasional run preempted by the system or slowed
+ * down by another process, so they are summarized by robust statistics: median
+ * and percentiles, outliers detected by the Tukey fences (outside
+ * [Q1 - 1.5 IQR, Q3 + 1.5 IQR]), and percentile bootstrap confidence intervals
+ * for the ratio of the medians of two sets of samples (e.g. a speedup).
+ */
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "random.hpp"
+
+using namespace std;
+
+/**
+ * Computes a percentile of sorted samples, interpolating between the closest ranks
+ *
+ * @param sorted samples in ascending order, not empty
+ * @param p percentile, in [0, 100]
+ */
+inline double percentile(const vector<double>& sorted, double p) {
+  double rank = p / 100 * (sorted.size() - 1);
+  size_t below = (size_t) floor(rank);
+  size_t above = min(below + 1, sorted.size() - 1);
+  return sorted[below] + (rank - below) * (sorted[above] - sorted[below]);
+}
+
+/**
+ * Summary of a set of samples
+ */
+struct Summary {
+  long count;
+  double min;
+  double max;
+  double mean;
+  double stddev;
+  double median;
+  double p5;
+  double p25;
+  double p75;
+  double p95;
+  // samples outside the Tukey fences
+  long outliers;
+};
+
+/**
+ * @param samples samples to be summarized, not empty
+ * @returns the summary of the samples
+ */
+inline Summary summarize(vector<double> samples) {
+  if (samples.empty()) throw "Invalid parameters, check framework API";
+  sort(samples.begin(), samples.end());
+  Summary s;
+  s.count = samples.size();
+  s.min = samples.front();
+  s.max = samples.back();
+  double sum = 0;
+  for (double x : samples) sum += x;
+  s.mean = sum / s.count;
+  double squares = 0;
+  for (double x : samples) squares += (x - s.mean) * (x - s.mean);
+  s.stddev = s.count > 1 ? sqrt(squares / (s.count - 1)) : 0;
+  s.median = percentile(samples, 50);
+  s.p5 = percentile(samples, 5);
+  s.p25 = percentile(samples, 25);
+  s.p75 = percentile(samples, 75);
+  s.p95 = percentile(samples, 95);
+  double iqr = s.p75 - s.p25;
+  s.outliers = 0;
+  for (double x : samples) {
+    if (x < s.p25 - 1.5 * iqr || x > s.p75 + 1.5 * iqr) s.outliers++;
+  }
+  return s;
+}
+
+/**
+ * Confidence interval of an estimate
+ */
+struct Interval {
+  double estimate;
+  double low;
+  double high;
+};
+
+/**
+ * Percentile bootstrap of the ratio between the medians of two sets of samples,
+ * such as the speedup of a parallel configuration over the sequential one
+ *
+ * @param numerators samples whose median is the numerator, not empty
+ * @param denominators samples whose median is the denominator, not empty
+ * @param level confidence level, e.g. 0.95
+ * @param resamples number of bootstrap resamples
+ * @param seed seed of the resampling, so that the intervals are reproducible
+ * @returns the ratio of the medians and its confidence interval
+ */
+inline Interval bootstrapRatio(const vector<double>& numerators, const vector<double>& denominators,
+                               double level = 0.95, int resamples = 2000, uint64_t seed = 112233) {
+  if (numerators.empty() || denominators.empty() || level <= 0 || level >= 1 || resamples <= 0) {
+    throw "Invalid parameters, check framework API";
+  }
+  auto median = [](vector<double> samples) {
+    sort(samples.begin(), samples.end());
+    return percentile(samples, 50);
+  };
+  Interval result;
+  result.estimate = median(numerators) / median(denominators);
+  vector<double> ratios(resamples);
+  vector<double> n(numerators.size());
+  vector<double> d(denominators.size());
+  uint64_t draw = 0;
+  for (int r = 0; r < resamples; r++) {
+    for (auto& x : n) x = numerators[counterRandom(seed, draw++) % numerators.size()];
+    for (auto& x : d) x = denominators[counterRandom(seed, draw++) % denominators.size()];
+    ratios[r] = median(n) / median(d);
+  }
+  sort(ratios.begin(), ratios.end());
+  result.low = percentile(ratios, (1 - level) / 2 * 100);
+  result.high = percentile(ratios, (1 + level) / 2 * 100);
+  return result;
+}
+
+#endif
@@ -0,0 +1,269 @@
+/**
+ * POSIX shared-memory ring of generations, letting local processes read the
+ * latest generations of the automaton without copies and without ever blocking
+ * the simulation.
+ *
+ * The segment starts with a ShmRingHeader, followed by slots of one
+ * ShmSlotHeader and height * width cells of one byte each (values are truncated
+ * to 8 bits). Each slot is protected by a seqlock: its sequence number is odd
+ * while the Game writes it and even once it is complete, so that a reader which
+ * observed the same even sequence before and after reading a slot knows the
+ * cells were not overwritten meanwhile. The writer never waits: the oldest slot
+ * is reused, and readers which were too slow simply retry.
+ *
+ * The sequence numbers are shared between processes, so the 64 bits atomics
+ * must be lock-free (address-free): both the ring and the reader throw when
+ * they are not on the platform.
+ */
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// identifies a generation ring
+const char RING_MAGIC[8] = {'C', 'A', 'R', 'I', 'N', 'G', 0, 0};
+// current version of the layout
+const uint32_t RING_VERSION = 1;
+
+static_assert(sizeof(atomic<uint64_t>) == 8, "the ring needs lock-free 64 bits atomics");
+#if __cplusplus >= 201703L
+static_assert(atomic<uint64_t>::is_always_lock_free && atomic<int64_t>::is_always_lock_free,
+              "the ring needs lock-free 64 bits atomics");
+#endif
+
+/**
+ * Header of the ring, at the beginning of the segment
+ */
+struct ShmRingHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t slots;
+  uint64_t height;
+  uint64_t width;
+  // distance in bytes between two slots
+  uint64_t slotBytes;
+  // number of generations completely published
+  atomic<uint64_t> published;
+  char padding[16];
+};
+
+/**
+ * Header of a slot, followed by its cells
+ */
+struct ShmSlotHeader {
+  // odd while the slot is being written
+  atomic<uint64_t> sequence;
+  // generation stored in the slot
+  atomic<int64_t> generation;
+  char padding[48];
+};
+
+static_assert(sizeof(ShmRingHeader) == 64 && sizeof(ShmSlotHeader) == 64, "ring headers must be 64 bytes long");
+
+/**
+ * @returns whether the atomics of the headers are lock-free, and hence usable
+ * across processes
+ */
+inline bool ringLockFree() {
+  atomic<uint64_t> sequence(0);
+  atomic<int64_t> generation(0);
+  return sequence.is_lock_free() && generation.is_lock_free();
+}
+
+/**
+ * Class owning the segment and publishing the generations, used by the Game
+ */
+class ShmRing {
+  private:
+    string name;
+    void* base;
+    size_t length;
+    ShmRingHeader* header;
+    // a generation is published when it is a multiple of every
+    long every;
+    // slot being written, nullptr if none
+    ShmSlotHeader* writing;
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    ShmSlotHeader* slot(uint64_t i) {
+      return (ShmSlotHeader*) ((char*) base + sizeof(ShmRingHeader) + i * header->slotBytes);
+    }
+
+  public:
+    /**
+     * Constructor, creates the segment, which is removed by the destructor
+     *
+     * @param name name of the segment, as for shm_open (e.g. "/life")
+     * @param height number of rows of the automaton
+     * @param width number of columns of the automaton
+     * @param slots number of generations kept in the ring
+     * @param every a generation is published when it is a multiple of every
+     */
+    ShmRing(const char* name, long height, long width, int slots = 4, long every = 1):
+      name(name), every(every) {
+        if (height <= 0 || width <= 0 || slots <= 0 || every <= 0) {
+          throw "Invalid parameters, check framework API";
+        }
+        if (!ringLockFree()) throw "The shared memory ring needs lock-free 64 bits atomics";
+        // slots aligned to a cache line
+        uint64_t slotBytes = (sizeof(ShmSlotHeader) + height * width + 63) / 64 * 64;
+        length = sizeof(ShmRingHeader) + slots * slotBytes;
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw "Cannot create the shared memory segment";
+        if (ftruncate(fd, length) != 0) {
+          close(fd);
+          shm_unlink(name);
+          throw "Cannot create the shared memory segment";
+        }
+        base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+          shm_unlink(name);
+          throw "Cannot map the shared memory segment";
+        }
+        header = (ShmRingHeader*) base;
+        header->version = RING_VERSION;
+        header->slots = slots;
+        header->height = height;
+        header->width = width;
+        header->slotBytes = slotBytes;
+        header->published.store(0);
+        for (int i = 0; i < slots; i++) {
+          slot(i)->sequence.store(0);
+          slot(i)->generation.store(-1);
+        }
+        writing = nullptr;
+        // readers validate the magic last
+        atomic_thread_fence(memory_order_release);
+        memcpy(header->magic, RING_MAGIC, sizeof(header->magic));
+    }
+
+    // Destructor
+    ~ShmRing() {
+      munmap(base, length);
+      shm_unlink(name.c_str());
+    }
+
+    // Getters
+    long getHeight() { return header->height; }
+    long getWidth() { return header->width; }
+    long getPublished() { return header->published.load(); }
+
+    /**
+     * @returns true if the given generation has to be published
+     */
+    bool wants(long generation) { return generation % every == 0; }
+
+    /**
+     * Starts writing the oldest slot, marking it as in progress
+     *
+     * @param generation generation that is going to be written
+     * @returns the cells of the slot, to be filled before end()
+     */
+    uint8_t* begin(long generation) {
+      writing = slot(header->published.load(memory_order_relaxed) % header->slots);
+      writing->sequence.store(writing->sequence.load(memory_order_relaxed) + 1, memory_order_relaxed);
+      atomic_thread_fence(memory_order_release);
+      writing->generation.store(generation, memory_order_relaxed);
+      return (uint8_t*) (writing + 1);
+    }
+
+    /**
+     * Completes the slot started by begin(), making it the latest generation
+     */
+    void end() {
+      writing->sequence.store(writing->sequence.load(memory_order_relaxed) + 1, memory_order_release);
+      header->published.fetch_add(1, memory_order_release);
+      writing = nullptr;
+    }
+};
+
+/**
+ * Class mapping a ring read-only from another process
+ */
+class ShmRingReader {
+  private:
+    void* base;
+    size_t length;
+    const ShmRingHeader* header;
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+  public:
+    /**
+     * Constructor, maps the segment created by a ShmRing
+     *
+     * @param name name of the segment
+     */
+    ShmRingReader(const char* name) {
+      if (!ringLockFree()) throw "The shared memory ring needs lock-free 64 bits atomics";
+      int fd = shm_open(name, O_RDONLY, 0);
+      if (fd < 0) throw "Cannot open the shared memory segment";
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(ShmRingHeader)) {
+        close(fd);
+        throw "Invalid shared memory segment";
+      }
+      length = st.st_size;
+      base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if (base == MAP_FAILED) throw "Cannot map the shared memory segment";
+      header = (const ShmRingHeader*) base;
+      bool valid = memcmp(header->magic, RING_MAGIC, sizeof(header->magic)) == 0;
+      atomic_thread_fence(memory_order_acquire);
+      valid = valid && header->version == RING_VERSION
+              && sizeof(ShmRingHeader) + header->slots * header->slotBytes <= length;
+      if (!valid) {
+        munmap(base, length);
+        throw "Invalid shared memory segment";
+      }
+    }
+
+    // Destructor
+    ~ShmRingReader() { munmap(base, length); }
+
+    // Getters
+    long getHeight() { return header->height; }
+    long getWidth() { return header->width; }
+    long getPublished() { return header->published.load(memory_order_acquire); }
+
+    /**
+     * Reads the latest generation in place. The cells can be overwritten by the
+     * Game while read reads them: in that case the result of read must be
+     * discarded, and it is called again on the new latest generation
+     *
+     * @param read function read(generation, cells) called on the row-major cells
+     * @param attempts maximum number of attempts
+     * @returns false if no generation was published or every attempt was torn
+     */
+    template<class F>
+    bool readLatest(F read, int attempts = 16) {
+      for (int a = 0; a < attempts; a++) {
+        uint64_t published = header->published.load(memory_order_acquire);
+        if (published == 0) return false;
+        const ShmSlotHeader* s = (const ShmSlotHeader*) ((const char*) base + sizeof(ShmRingHeader)
+                                 + (published - 1) % header->slots * header->slotBytes);
+        uint64_t before = s->sequence.load(memory_order_acquire);
+        if (before % 2 == 1) continue;
+        long generation = s->generation.load(memory_order_relaxed);
+        read(generation, (const uint8_t*) (s + 1));
+        atomic_thread_fence(memory_order_acquire);
+        if (s->sequence.load(memory_order_relaxed) == before) return true;
+      }
+      return false;
+    }
+};
+
+#endif
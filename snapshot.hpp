@@ -0,0 +1,298 @@
+/**
+ * Binary snapshot format used to checkpoint and resume the automaton.
+ *
+ * A snapshot is a 64 bytes header followed by the height * width cells of the
+ * current generation in row-major order, either as 32 bits ints (which can be
+ * used in place once mapped on little endian hosts) or as one byte per cell.
+ * Stripes of cells are written independently with pwrite, so that the workers
+ * can save their part of the table in parallel.
+ *
+ * All integers, header fields and cells, are serialized as little endian (see
+ * byte_order.hpp). Version 1 snapshots were written in the byte order of the
+ * host, and are still read on little endian hosts, where they are identical.
+ */
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "byte_order.hpp"
+
+using namespace std;
+
+// identifies a snapshot file
+const char SNAPSHOT_MAGIC[8] = {'C', 'A', 'S', 'N', 'A', 'P', 0, 0};
+// current version of the format
+const uint32_t SNAPSHOT_VERSION = 2;
+
+// cells stored as 32 bits ints, restored without copies on little endian hosts
+const uint32_t SNAPSHOT_INT32 = 0;
+// cells stored as one byte each, values must be in [0, 255]
+const uint32_t SNAPSHOT_UINT8 = 1;
+
+/**
+ * Header of a snapshot file, as decoded in memory
+ */
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  // one of SNAPSHOT_INT32, SNAPSHOT_UINT8
+  uint32_t encoding;
+  uint64_t height;
+  uint64_t width;
+  // generation stored in the snapshot
+  uint64_t generation;
+  // identifier of the rule, chosen by the application
+  uint32_t ruleId;
+  uint32_t reserved;
+  // offset of the first cell in the file
+  uint64_t dataOffset;
+  uint64_t padding;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "the snapshot header must be 64 bytes long");
+
+/**
+ * Serializes a header in the 64 bytes of out, fields in declaration order
+ */
+inline void snapshotEncodeHeader(const SnapshotHeader& header, uint8_t* out) {
+  memcpy(out, header.magic, sizeof(header.magic));
+  storeLittleEndian(out + 8, header.version, 4);
+  storeLittleEndian(out + 12, header.encoding, 4);
+  storeLittleEndian(out + 16, header.height, 8);
+  storeLittleEndian(out + 24, header.width, 8);
+  storeLittleEndian(out + 32, header.generation, 8);
+  storeLittleEndian(out + 40, header.ruleId, 4);
+  storeLittleEndian(out + 44, header.reserved, 4);
+  storeLittleEndian(out + 48, header.dataOffset, 8);
+  storeLittleEndian(out + 56, header.padding, 8);
+}
+
+/**
+ * Reads a header serialized by snapshotEncodeHeader
+ */
+inline SnapshotHeader snapshotDecodeHeader(const uint8_t* in) {
+  SnapshotHeader header;
+  memcpy(header.magic, in, sizeof(header.magic));
+  header.version = getLittleEndian(in + 8, 4);
+  header.encoding = getLittleEndian(in + 12, 4);
+  header.height = getLittleEndian(in + 16, 8);
+  header.width = getLittleEndian(in + 24, 8);
+  header.generation = getLittleEndian(in + 32, 8);
+  header.ruleId = getLittleEndian(in + 40, 4);
+  header.reserved = getLittleEndian(in + 44, 4);
+  header.dataOffset = getLittleEndian(in + 48, 8);
+  header.padding = getLittleEndian(in + 56, 8);
+  return header;
+}
+
+/**
+ * @param encoding one of SNAPSHOT_INT32, SNAPSHOT_UINT8
+ * @returns the number of bytes used to store a cell
+ */
+inline long snapshotCellBytes(uint32_t encoding) {
+  return encoding == SNAPSHOT_INT32 ? sizeof(int32_t) : sizeof(uint8_t);
+}
+
+/**
+ * Writes the whole buffer at the given offset, retrying on partial writes
+ *
+ * @returns false if the write failed
+ */
+inline bool pwriteAll(int fd, const void* buffer, size_t count, off_t offset) {
+  const char* p = (const char*) buffer;
+  while (count > 0) {
+    ssize_t n = pwrite(fd, p, count, offset);
+    if (n <= 0) return false;
+    p += n;
+    count -= n;
+    offset += n;
+  }
+  return true;
+}
+
+/**
+ * Creates a snapshot file with the given dimensions and writes its header.
+ * The cells must then be written with snapshotWriteCells
+ *
+ * @returns the file descriptor of the snapshot, to be closed by the caller
+ */
+inline int snapshotCreate(const char* path, long height, long width, long generation,
+                          uint32_t ruleId, uint32_t encoding) {
+  if (encoding != SNAPSHOT_INT32 && encoding != SNAPSHOT_UINT8) {
+    throw "Unknown snapshot encoding";
+  }
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.encoding = encoding;
+  header.height = height;
+  header.width = width;
+  header.generation = generation;
+  header.ruleId = ruleId;
+  header.dataOffset = sizeof(SnapshotHeader);
+
+  uint8_t encoded[sizeof(SnapshotHeader)];
+  snapshotEncodeHeader(header, encoded);
+
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) throw "Cannot create the snapshot file";
+  off_t total = header.dataOffset + height * width * snapshotCellBytes(encoding);
+  if (ftruncate(fd, total) != 0 || !pwriteAll(fd, encoded, sizeof(encoded), 0)) {
+    close(fd);
+    throw "Cannot write the snapshot header";
+  }
+  return fd;
+}
+
+/**
+ * Writes a stripe of consecutive cells in the snapshot. Stripes are independent,
+ * so different threads can write different stripes of the same file
+ *
+ * @param fd file descriptor returned by snapshotCreate
+ * @param encoding encoding given to snapshotCreate
+ * @param first row-major index of the first cell of the stripe
+ * @param values values of the cells
+ * @param count number of cells
+ * @returns false if the write failed
+ */
+inline bool snapshotWriteCells(int fd, uint32_t encoding, long first, const int* values, long count) {
+  off_t offset = sizeof(SnapshotHeader) + first * snapshotCellBytes(encoding);
+  if (encoding == SNAPSHOT_INT32 && hostIsLittleEndian()) {
+    return pwriteAll(fd, values, count * sizeof(int32_t), offset);
+  }
+  vector<uint8_t> bytes(count * snapshotCellBytes(encoding));
+  for (long i = 0; i < count; i++) {
+    if (encoding == SNAPSHOT_INT32) storeLittleEndian(&bytes[4 * i], (uint32_t) values[i], 4);
+    else bytes[i] = (uint8_t) values[i];
+  }
+  return pwriteAll(fd, bytes.data(), bytes.size(), offset);
+}
+
+/**
+ * Writes a stripe of cells of a table in the snapshot, gathering them in chunks
+ * through getCellValue so that any table implementation can be saved
+ *
+ * @param fd file descriptor returned by snapshotCreate
+ * @param encoding encoding given to snapshotCreate
+ * @param table the table to save
+ * @param start row-major index of the first cell of the stripe
+ * @param stop row-major index past the last cell of the stripe
+ * @returns false if the write failed
+ */
+template<class T>
+bool snapshotWriteStripe(int fd, uint32_t encoding, T& table, long start, long stop) {
+  const long chunkSize = 1 << 16;
+  vector<int> chunk;
+  for (long first = start; first < stop; first += chunkSize) {
+    long count = stop - first < chunkSize ? stop - first : chunkSize;
+    chunk.resize(count);
+    for (long i = 0; i < count; i++) {
+      chunk[i] = table.getCellValue(first + i);
+    }
+    if (!snapshotWriteCells(fd, encoding, first, chunk.data(), count)) return false;
+  }
+  return true;
+}
+
+/**
+ * Class representing a snapshot mapped in memory
+ *
+ * The file is mapped privately: the cells can be used as the storage of a table
+ * and modified without altering the file, only the touched pages being copied
+ */
+class Snapshot {
+  private:
+    SnapshotHeader header;
+    // base of the mapping
+    void* base;
+    // length of the mapping
+    size_t length;
+    // cells decoded from a SNAPSHOT_UINT8 snapshot, or on big endian hosts
+    vector<int> decoded;
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+  public:
+    /**
+     * Maps the given snapshot file, validating its header
+     */
+    Snapshot(const char* path) {
+      int fd = ::open(path, O_RDONLY);
+      if (fd < 0) throw "Cannot open the snapshot file";
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(SnapshotHeader)) {
+        close(fd);
+        throw "Invalid snapshot file";
+      }
+      length = st.st_size;
+      base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (base == MAP_FAILED) throw "Cannot map the snapshot file";
+
+      header = snapshotDecodeHeader((const uint8_t*) base);
+      bool valid = memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0
+                   && (header.version == SNAPSHOT_VERSION || (header.version == 1 && hostIsLittleEndian()))
+                   && (header.encoding == SNAPSHOT_INT32 || header.encoding == SNAPSHOT_UINT8);
+      // the dimensions are bounded before any product, which could overflow
+      valid = valid && header.height > 0 && header.height <= INT_MAX
+              && header.width > 0 && header.width <= INT_MAX
+              && header.dataOffset >= sizeof(SnapshotHeader) && header.dataOffset <= length
+              && header.dataOffset % sizeof(int32_t) == 0
+              && header.height <= (length - header.dataOffset) / (header.width * snapshotCellBytes(header.encoding));
+      if (!valid) {
+        munmap(base, length);
+        throw "Invalid snapshot file";
+      }
+    }
+
+    // Destructor
+    ~Snapshot() { munmap(base, length); }
+
+    /**
+     * Maps the given snapshot file
+     *
+     * @returns a shared pointer, to be kept alive as long as the cells are in use
+     */
+    static shared_ptr<Snapshot> open(const char* path) {
+      return make_shared<Snapshot>(path);
+    }
+
+    // Getters
+    long getHeight() { return header.height; }
+    long getWidth() { return header.width; }
+    long getGeneration() { return header.generation; }
+    uint32_t getRuleId() { return header.ruleId; }
+    uint32_t getEncoding() { return header.encoding; }
+
+    /**
+     * Returns the cells as ints. For SNAPSHOT_INT32 snapshots on little endian
+     * hosts this is the mapped memory itself, otherwise the cells are decoded
+     * once into an owned buffer
+     */
+    int* getCells() {
+      uint8_t* data = (uint8_t*) base + header.dataOffset;
+      if (header.encoding == SNAPSHOT_INT32 && hostIsLittleEndian()) return (int*) data;
+      if (decoded.empty()) {
+        long size = header.height * header.width;
+        decoded.resize(size);
+        for (long i = 0; i < size; i++) {
+          if (header.encoding == SNAPSHOT_INT32) decoded[i] = (int32_t) getLittleEndian(data + 4 * i, 4);
+          else decoded[i] = data[i];
+        }
+      }
+      return decoded.data();
+    }
+};
+
+#endif
@@ -1,6 +1,11 @@
 #include <iostream>
 #include <chrono>
 #include <vector>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "sampling.hpp"
 
 //#include "frame_threads_1D.hpp"
 //#include "frame_threads_2D.hpp"
@@ -34,60 +39,199 @@ class Test: public Game {
     }
 };
 
+/**
+ * Class measuring the scalability of the Test application: each configuration
+ * (number of workers) is timed over several runs, each one on a new Game
+ * started from the same input and preceded by warm-up runs, and the speedup and
+ * efficiency are reported with bootstrap confidence intervals (see sampling.hpp)
+ */
 class Benchmark {
   private:
     long width;
     long height;
-    long size;
     int max_nw;
-    long seq_time;
     int n_steps;
-    vector<Test*> apps;
-    vector<double> timings;
-    vector<double> overheads;
-    
+    vector<int> input;
+    // numbers of workers measured, the first one being 1
+    vector<int> workers;
+    // runs discarded before the timed ones
+    int warmups;
+    // timed runs of each configuration
+    int runs;
+    // confidence level of the intervals
+    double level;
+    // number of bootstrap resamples
+    int resamples;
+    // whether to measure each configuration in its own process
+    bool isolated;
+    // timings and overheads of the runs of each configuration, in us
+    vector<vector<double>> timings;
+    vector<vector<double>> overheads;
+
+    /**
+     * Times the warm-up and the timed runs of a configuration, each one on a new
+     * Game whose construction is not timed
+     */
+    void measure(int nw, vector<double>& times, vector<double>& overs) {
+      for (int i = 0; i < warmups + runs; i++) {
+        Test t(height, width, nw, input);
+        auto startTime = Clock::now();
+        double over = t.run(n_steps);
+        auto endTime = Clock::now();
+        if (i < warmups) continue;
+        times.push_back(chrono::duration_cast<chrono::microseconds>(endTime - startTime).count());
+        overs.push_back(over);
+      }
+    }
+
+    /**
+     * Measures a configuration in a child process, so that it does not inherit
+     * the heap, caches and frequency state left by the previous ones
+     *
+     * @returns false if the child failed
+     */
+    bool measureIsolated(int nw, vector<double>& times, vector<double>& overs) {
+      int fds[2];
+      if (pipe(fds) != 0) throw "Cannot create the pipe to the benchmark process";
+      pid_t pid = fork();
+      if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        throw "Cannot create the benchmark process";
+      }
+      if (pid == 0) {
+        close(fds[0]);
+        int status = 0;
+        try {
+          measure(nw, times, overs);
+          vector<double> samples(times);
+          samples.insert(samples.end(), overs.begin(), overs.end());
+          size_t bytes = samples.size() * sizeof(double);
+          if (write(fds[1], samples.data(), bytes) != (ssize_t) bytes) status = 1;
+        } catch (const char* msg) {
+          cerr << msg << endl;
+          status = 1;
+        }
+        close(fds[1]);
+        _exit(status);
+      }
+      close(fds[1]);
+      vector<double> samples(2 * runs);
+      size_t bytes = samples.size() * sizeof(double);
+      size_t got = 0;
+      ssize_t n;
+      while (got < bytes && (n = read(fds[0], (char*) samples.data() + got, bytes - got)) > 0) got += n;
+      close(fds[0]);
+      int status;
+      waitpid(pid, &status, 0);
+      if (got != bytes || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return false;
+      times.assign(samples.begin(), samples.begin() + runs);
+      overs.assign(samples.begin() + runs, samples.end());
+      return true;
+    }
+
   public:
-    Benchmark(long height, long width, vector<int> input, int max_nw, int n_steps): 
-      height(height), width(width), max_nw(max_nw), n_steps(n_steps) {
+    /**
+     * Constructor, measuring by default 1, 2, 4, ... and max_nw workers
+     *
+     * @param height number of rows
+     * @param width number of columns
+     * @param input initial cells of every run
+     * @param max_nw maximum number of workers
+     * @param n_steps steps of each run
+     * @param runs timed runs of each configuration
+     * @param warmups runs discarded before the timed ones
+     */
+    Benchmark(long height, long width, vector<int> input, int max_nw, int n_steps, int runs = 5, int warmups = 1):
+      height(height), width(width), max_nw(max_nw), n_steps(n_steps), input(input), warmups(warmups), runs(runs) {
+        if (max_nw <= 0 || n_steps <= 0 || runs <= 0 || warmups < 0) {
+          throw "Invalid parameters, check framework API";
+        }
         for (int nw = 1; nw <= max_nw; nw *= 2) {
-          try {
-            Test* t = new Test(height, width, nw, input);
-            apps.push_back(t);
-          } catch (const char* msg) {
-            cerr << msg << endl;
-          }
+          workers.push_back(nw);
         }
+        if (workers.back() != max_nw) workers.push_back(max_nw);
+        level = 0.95;
+        resamples = 2000;
+        isolated = false;
     }
 
+    /**
+     * Sets the numbers of workers to be measured, 1 being always measured first
+     * as the baseline
+     */
+    void setWorkers(const vector<int>& counts) {
+      workers = {1};
+      for (int nw : counts) {
+        if (nw <= 0) throw "Invalid parameters, check framework API";
+        if (nw != 1) workers.push_back(nw);
+      }
+    }
+
+    /**
+     * Sets the confidence level and the number of resamples of the intervals
+     */
+    void setConfidence(double level, int resamples = 2000) {
+      if (level <= 0 || level >= 1 || resamples <= 0) throw "Invalid parameters, check framework API";
+      this->level = level;
+      this->resamples = resamples;
+    }
+
+    /**
+     * Sets whether each configuration is measured in its own process
+     */
+    void setIsolation(bool isolated) { this->isolated = isolated; }
+
+    // Getters
+    const vector<int>& getWorkers() { return workers; }
+    // timings of the runs of the i-th configuration, empty if it failed
+    const vector<double>& getTimings(int i) { return timings[i]; }
+    const vector<double>& getOverheads(int i) { return overheads[i]; }
+
   void bench() {
-    seq_time = 0;
-    auto startTime = Clock::now();
-    apps[0]->run(n_steps);
-    auto endTime = Clock::now();
-    seq_time = chrono::duration_cast<chrono::microseconds>(endTime - startTime).count();
-    overheads.push_back(0);
-    timings.push_back(seq_time);
-    double over = 0;
-
-    for (int i = 1; i < apps.size(); i++) {
-      startTime = Clock::now();
-      over = apps[i]->run(n_steps);
-      overheads.push_back(over);
-      endTime = Clock::now();
-      timings.push_back(chrono::duration_cast<chrono::microseconds>(endTime - startTime).count());
+    timings = vector<vector<double>>(workers.size());
+    overheads = vector<vector<double>>(workers.size());
+    for (size_t i = 0; i < workers.size(); i++) {
+      try {
+        if (isolated) {
+          if (!measureIsolated(workers[i], timings[i], overheads[i])) {
+            cerr << "Benchmark process on " << workers[i] << " cores failed" << endl;
+          }
+        }
+        else measure(workers[i], timings[i], overheads[i]);
+      } catch (const char* msg) {
+        cerr << msg << endl;
+        timings[i].clear();
+        overheads[i].clear();
+      }
     }
 
-    cout << "Application running " << n_steps << " steps on matrix " << height << "x" << width << endl << endl;
-    cout << "Sequential time:                         " << seq_time << " us" << endl;
-    int n_cores = 1;
-    for (int i = 1; i < apps.size(); i++) {
-      double serial_f = overheads[i] / timings[i];
-      cout << "Application running on " << (n_cores *= 2) << " cores:          " << timings[i] << " us" << endl;
-      cout << "Overhead:                                " << overheads[i] << " us" << endl;
-      cout << "Serial fraction:                         " << serial_f << endl;
-      cout << "Efficiency:                              " << (seq_time / timings[i]) / n_cores << endl;
-      cout << "Speedup(" << n_cores << "):                              " << seq_time / timings[i] << endl;
-      delete(apps[i]);
+    cout << "Application running " << n_steps << " steps on matrix " << height << "x" << width << endl;
+    cout << runs << " runs after " << warmups << " warm-up runs per configuration"
+         << (isolated ? ", each configuration in its own process" : "") << endl << endl;
+    if (timings[0].empty()) {
+      cerr << "Sequential configuration failed" << endl;
+      return;
+    }
+    string confidence = to_string((int) (level * 100 + 0.5)) + "% CI";
+    for (size_t i = 0; i < workers.size(); i++) {
+      if (timings[i].empty()) continue;
+      Summary t = summarize(timings[i]);
+      Summary o = summarize(overheads[i]);
+      if (i == 0) cout << "Sequential time:" << endl;
+      else cout << "Application running on " << workers[i] << " cores:" << endl;
+      cout << "  Median time:                           " << t.median << " us" << endl;
+      cout << "  Percentiles 5/25/75/95:                " << t.p5 << " / " << t.p25 << " / " << t.p75 << " / " << t.p95 << " us" << endl;
+      cout << "  Mean time:                             " << t.mean << " +- " << t.stddev << " us" << endl;
+      cout << "  Outliers:                              " << t.outliers << " of " << t.count << endl;
+      if (i == 0) continue;
+      Interval speedup = bootstrapRatio(timings[0], timings[i], level, resamples);
+      cout << "  Median overhead:                       " << o.median << " us" << endl;
+      cout << "  Serial fraction:                       " << o.median / t.median << endl;
+      cout << "  Speedup(" << workers[i] << "):                            " << speedup.estimate
+           << " [" << speedup.low << ", " << speedup.high << "] " << confidence << endl;
+      cout << "  Efficiency:                            " << speedup.estimate / workers[i]
+           << " [" << speedup.low / workers[i] << ", " << speedup.high / workers[i] << "] " << confidence << endl;
     }
   }
-};
\ No newline at end of file
+};
@@ -0,0 +1,318 @@
+/**
+ * Output stage streaming generations of the automaton to disk from a dedicated
+ * writer thread.
+ *
+ * The Game captures every k-th generation into a recycled buffer (each worker
+ * copying its own stripe at the beginning of the following step) and submits
+ * it to the stream, whose writer thread hands it to a FrameSink while the
+ * simulation goes on.
+ */
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A generation captured from the Game
+ */
+struct GenerationFrame {
+  long generation;
+  // row-major values of the cells
+  vector<int> cells;
+};
+
+/**
+ * Interface of the consumers of the frames, called from the writer thread. A
+ * sink reports an output error by throwing, the stream then stops handing it
+ * frames and reports the error to the Game
+ */
+class FrameSink {
+  public:
+    /**
+     * Consumes a frame, the cells are valid only during the call
+     *
+     * @param generation generation of the frame
+     * @param cells row-major values of the cells
+     * @param height number of rows
+     * @param width number of columns
+     */
+    virtual void write(long generation, const int* cells, long height, long width) = 0;
+
+    /**
+     * Flushes the output once the last frame has been written
+     */
+    virtual void close() {}
+
+    virtual ~FrameSink() {}
+};
+
+/**
+ * Flushes and closes a file written by a sink
+ */
+inline void closeSinkFile(FILE*& file) {
+  if (file == nullptr) return;
+  bool flushed = fflush(file) == 0;
+  bool closed = fclose(file) == 0;
+  file = nullptr;
+  if (!flushed || !closed) throw "Cannot write the output file";
+}
+
+/**
+ * Sink writing the frames in a binary file, each frame being a header of three
+ * 64 bits integers (generation, height, width) followed by one byte per cell
+ */
+class RawFileSink: public FrameSink {
+  private:
+    FILE* file;
+    vector<uint8_t> bytes;
+
+  public:
+    // Constructor
+    RawFileSink(const char* path) {
+      file = fopen(path, "wb");
+      if (file == nullptr) throw "Cannot open the output file";
+    }
+
+    // Destructor
+    ~RawFileSink() {
+      if (file != nullptr) fclose(file);
+    }
+
+    void write(long generation, const int* cells, long height, long width) {
+      int64_t header[3] = {generation, height, width};
+      bytes.resize(height * width);
+      for (long i = 0; i < height * width; i++) {
+        bytes[i] = (uint8_t) cells[i];
+      }
+      if (fwrite(header, sizeof(header), 1, file) != 1
+          || fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size()) {
+        throw "Cannot write the output file";
+      }
+    }
+
+    void close() { closeSinkFile(file); }
+};
+
+/**
+ * Sink writing the frames in a text file, with the same glyphs used by print()
+ */
+class TextFileSink: public FrameSink {
+  private:
+    FILE* file;
+    vector<char> text;
+
+  public:
+    // Constructor
+    TextFileSink(const char* path) {
+      file = fopen(path, "w");
+      if (file == nullptr) throw "Cannot open the output file";
+    }
+
+    // Destructor
+    ~TextFileSink() {
+      if (file != nullptr) fclose(file);
+    }
+
+    void write(long generation, const int* cells, long height, long width) {
+      text.resize(height * (width + 1) + 1);
+      char* p = text.data();
+      for (long i = 0; i < height; i++) {
+        for (long j = 0; j < width; j++) {
+          *p++ = cells[i * width + j] == 0 ? '-' : 'x';
+        }
+        *p++ = '\n';
+      }
+      *p++ = '\n';
+      if (fprintf(file, "generation %ld\n", generation) < 0
+          || fwrite(text.data(), 1, text.size(), file) != text.size()) {
+        throw "Cannot write the output file";
+      }
+    }
+
+    void close() { closeSinkFile(file); }
+};
+
+/**
+ * Class representing the output stage: a queue of captured frames consumed by a
+ * writer thread, and a pool of buffers recycled once written
+ */
+class GenerationStream {
+  private:
+    long height;
+    long width;
+    // a generation is captured when it is a multiple of every
+    long every;
+    unique_ptr<FrameSink> sink;
+    // frames waiting to be written
+    deque<GenerationFrame*> queue;
+    // frames ready to be captured into
+    vector<GenerationFrame*> pool;
+    // all the frames, owned by the stream
+    vector<unique_ptr<GenerationFrame>> frames;
+    mutex m;
+    // signaled when a frame is queued or the stream is closed
+    condition_variable queued;
+    // signaled when a frame goes back to the pool
+    condition_variable recycled;
+    bool closing;
+    // whether frames are dropped instead of waiting for a free buffer
+    bool dropping;
+    // number of frames dropped
+    long dropped;
+    // first error reported by the sink, no frame is written after it
+    atomic<const char*> error;
+    thread writer;
+
+    /**
+     * Body of the writer thread
+     */
+    void writeLoop() {
+      while (true) {
+        GenerationFrame* frame;
+        {
+          unique_lock<mutex> lock(m);
+          queued.wait(lock, [&] { return !queue.empty() || closing; });
+          if (queue.empty()) return;
+          frame = queue.front();
+          queue.pop_front();
+        }
+        if (error.load() == nullptr) {
+          try {
+            sink->write(frame->generation, frame->cells.data(), height, width);
+          } catch (const char* msg) {
+            error = msg;
+          }
+        }
+        {
+          unique_lock<mutex> lock(m);
+          pool.push_back(frame);
+        }
+        recycled.notify_one();
+      }
+    }
+
+    /**
+     * Writes the pending frames, stops the writer thread and flushes the sink
+     */
+    void stop() {
+      {
+        unique_lock<mutex> lock(m);
+        if (closing) return;
+        closing = true;
+      }
+      queued.notify_one();
+      writer.join();
+      try {
+        sink->close();
+      } catch (const char* msg) {
+        if (error.load() == nullptr) error = msg;
+      }
+    }
+
+  public:
+    /**
+     * Constructor, starts the writer thread
+     *
+     * @param height number of rows of the automaton
+     * @param width number of columns of the automaton
+     * @param every a generation is written when it is a multiple of every
+     * @param sink consumer of the frames
+     * @param buffers number of frames that can be in flight, the Game waits
+     * for a free one when the writer falls behind unless drop is set
+     * @param drop whether to skip the frames captured while no buffer is free,
+     * so that the simulation never waits for the writer
+     */
+    GenerationStream(long height, long width, long every, unique_ptr<FrameSink> sink, int buffers = 3,
+                     bool drop = false):
+      height(height), width(width), every(every), sink(move(sink)), dropping(drop) {
+        if (height <= 0 || width <= 0 || every <= 0 || buffers <= 0) {
+          throw "Invalid parameters, check framework API";
+        }
+        for (int i = 0; i < buffers; i++) {
+          frames.push_back(unique_ptr<GenerationFrame>(new GenerationFrame()));
+          frames[i]->cells.resize(height * width);
+          pool.push_back(frames[i].get());
+        }
+        closing = false;
+        dropped = 0;
+        error = nullptr;
+        writer = thread(&GenerationStream::writeLoop, this);
+    }
+
+    // Destructor, errors of the sink are only reported by close()
+    ~GenerationStream() { stop(); }
+
+    // Getters
+    long getHeight() { return height; }
+    long getWidth() { return width; }
+    long getDropped() {
+      unique_lock<mutex> lock(m);
+      return dropped;
+    }
+    const char* getError() { return error.load(); }
+
+    /**
+     * Throws the first error reported by the sink, if any
+     */
+    void check() {
+      const char* msg = error.load();
+      if (msg != nullptr) throw msg;
+    }
+
+    /**
+     * @returns true if the given generation has to be written
+     */
+    bool wants(long generation) { return generation % every == 0; }
+
+    /**
+     * Takes a buffer from the pool, waiting for the writer if none is free and
+     * frames are not dropped
+     *
+     * @param generation generation that is going to be captured
+     * @returns the buffer, nullptr if the frame is dropped
+     */
+    GenerationFrame* acquire(long generation) {
+      unique_lock<mutex> lock(m);
+      if (dropping && pool.empty()) {
+        dropped++;
+        return nullptr;
+      }
+      recycled.wait(lock, [&] { return !pool.empty(); });
+      GenerationFrame* frame = pool.back();
+      pool.pop_back();
+      frame->generation = generation;
+      return frame;
+    }
+
+    /**
+     * Hands a captured frame to the writer thread
+     */
+    void submit(GenerationFrame* frame) {
+      {
+        unique_lock<mutex> lock(m);
+        queue.push_back(frame);
+      }
+      queued.notify_one();
+    }
+
+    /**
+     * Writes the pending frames, stops the writer thread and flushes the sink,
+     * throwing if any frame could not be written
+     */
+    void close() {
+      stop();
+      check();
+    }
+};
+
+#endif
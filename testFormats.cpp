@@ -0,0 +1,462 @@
+/**
+ * Checks the binary formats of the framework: every file written is read back
+ * and compared with the state it was written from, and corrupt files must be
+ * rejected instead of being read past their end.
+ *
+ * Compile from the root of the repository with
+ *   g++ -std=c++14 -pthread -I. testFormats.cpp -o testFormats
+ */
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "bench_engines.hpp"
+
+/**
+ * Game of life accepting every constructor of the engine
+ */
+template<class G>
+class TestLife: public G {
+  public:
+    using G::G;
+
+    int rule(int value, vector<int> neighValues) {
+      int sum = 0;
+      for (int i = 0; i < 8; i++) {
+        sum += neighValues[i];
+      }
+      if (sum == 3 || (sum == 2 && value == 1)) return 1;
+      return 0;
+    }
+};
+
+/**
+ * @returns a pseudo-random board with about a third of the cells alive
+ */
+vector<int> soup(long height, long width) {
+  vector<int> input(height * width);
+  for (long i = 0; i < height * width; i++) {
+    input[i] = (i * 2654435761u >> 7) % 3 == 0;
+  }
+  return input;
+}
+
+/**
+ * @returns the cells of the current generation of a Game, in row-major order
+ */
+template<class G>
+vector<int> cellsOf(G& game) {
+  GridView view = game.view();
+  vector<int> cells;
+  for (long r = 0; r < view.getHeight(); r++) {
+    for (long c = 0; c < view.getWidth(); c++) {
+      cells.push_back(view(r, c));
+    }
+  }
+  return cells;
+}
+
+/**
+ * @returns a path for a temporary file of the test
+ */
+string tempPath(const string& name) {
+  return "/tmp/testFormats_" + to_string(getpid()) + "_" + name;
+}
+
+/**
+ * Saves a Game in both encodings and resumes it with other numbers of workers,
+ * checking the restored generation and the generations computed after it
+ */
+template<class G>
+bool checkSnapshotRoundTrip() {
+  long height = 37, width = 53;
+  TestLife<G> game(height, width, 3, soup(height, width));
+  game.run(4);
+  bool ok = true;
+  for (uint32_t encoding : {SNAPSHOT_INT32, SNAPSHOT_UINT8}) {
+    string path = tempPath("round.snap");
+    game.save(path.c_str(), 7, encoding);
+    for (int nw : {1, 2, 5}) {
+      auto snapshot = Snapshot::open(path.c_str());
+      TestLife<G> resumed(nw, snapshot);
+      ok = ok && snapshot->getRuleId() == 7 && resumed.getGeneration() == game.getGeneration()
+           && cellsOf(resumed) == cellsOf(game);
+      TestLife<G> reference(height, width, 2, cellsOf(game));
+      resumed.run(3);
+      reference.run(3);
+      ok = ok && cellsOf(resumed) == cellsOf(reference);
+    }
+    unlink(path.c_str());
+  }
+  return ok;
+}
+
+/**
+ * Checks that the header of a snapshot is serialized as little endian
+ */
+bool checkSnapshotByteOrder() {
+  string path = tempPath("order.snap");
+  int fd = snapshotCreate(path.c_str(), 3, 258, 0x0102030405L, 9, SNAPSHOT_INT32);
+  int cells[3 * 258] = {0};
+  cells[1] = 0x01020304;
+  bool ok = snapshotWriteCells(fd, SNAPSHOT_INT32, 0, cells, 3 * 258);
+  close(fd);
+  FILE* file = fopen(path.c_str(), "rb");
+  vector<uint8_t> bytes(64 + 8);
+  ok = ok && file != nullptr && fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  if (file != nullptr) fclose(file);
+  unlink(path.c_str());
+  const uint8_t width[8] = {2, 1, 0, 0, 0, 0, 0, 0};
+  const uint8_t generation[8] = {5, 4, 3, 2, 1, 0, 0, 0};
+  const uint8_t cell[4] = {4, 3, 2, 1};
+  return ok && bytes[16] == 3 && memcmp(&bytes[24], width, 8) == 0 && memcmp(&bytes[32], generation, 8) == 0
+         && memcmp(&bytes[68], cell, 4) == 0;
+}
+
+/**
+ * Writes a snapshot whose header holds the given dimensions, and the given
+ * number of bytes of cells
+ *
+ * @returns true if the snapshot is rejected when opened
+ */
+bool rejectsSnapshot(uint64_t height, uint64_t width, uint64_t dataOffset, size_t cellBytes) {
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.encoding = SNAPSHOT_INT32;
+  header.height = height;
+  header.width = width;
+  header.dataOffset = dataOffset;
+  vector<uint8_t> bytes(sizeof(header) + cellBytes, 0);
+  snapshotEncodeHeader(header, bytes.data());
+  string path = tempPath("corrupt.snap");
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return false;
+  bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  fclose(file);
+  bool rejected = false;
+  try {
+    Snapshot snapshot(path.c_str());
+  } catch (const char*) {
+    rejected = true;
+  }
+  unlink(path.c_str());
+  return written && rejected;
+}
+
+/**
+ * Checks that snapshots whose cells would lie past the end of the file are rejected
+ */
+bool checkSnapshotCorrupt() {
+  return rejectsSnapshot(4, 4, 64, 64) == false
+         // 2^62 * 4 * 4 bytes wraps around to 0
+         && rejectsSnapshot(1ULL << 62, 4, 64, 64)
+         && rejectsSnapshot(1ULL << 31, 1, 64, 1 << 12)
+         && rejectsSnapshot(4, 1ULL << 32, 64, 64)
+         && rejectsSnapshot(4, 4, 64, 63)
+         && rejectsSnapshot(4, 4, 1ULL << 63, 64)
+         && rejectsSnapshot(4, 4, 8, 64);
+}
+
+/**
+ * Saves a packed grid whose rows do not fill their last byte, checks its header
+ * and loads it back with one and with several threads
+ */
+bool checkPackedGridRoundTrip() {
+  long height = 13, width = 21;
+  vector<int> cells = soup(height, width);
+  string path = tempPath("round.grid");
+  savePackedGrid(path.c_str(), height, width, [&](long r, long c) { return cells[r * width + c]; });
+  MappedFile file(path.c_str());
+  const uint8_t dims[16] = {13, 0, 0, 0, 0, 0, 0, 0, 21, 0, 0, 0, 0, 0, 0, 0};
+  bool ok = file.size() == 24 + 13 * 3 && memcmp(file.data() + 8, dims, 16) == 0;
+  for (int nw : {1, 4}) {
+    vector<int> loaded(height * width, 0);
+    loadPackedGrid(file.data(), file.size(), 0, 0, nw, [&](long r, long c, int value) {
+      loaded[r * width + c] = value;
+    });
+    ok = ok && loaded == cells;
+  }
+  unlink(path.c_str());
+  return ok;
+}
+
+/**
+ * @returns true if a packed grid with the given dimensions, followed by the
+ * given number of bytes of cells, is rejected
+ */
+bool rejectsGrid(uint64_t height, uint64_t width, size_t cellBytes) {
+  vector<uint8_t> bytes(GRID_MAGIC, GRID_MAGIC + sizeof(GRID_MAGIC));
+  putLittleEndian(bytes, height, 8);
+  putLittleEndian(bytes, width, 8);
+  bytes.resize(bytes.size() + cellBytes, 0xff);
+  try {
+    loadPackedGrid((const char*) bytes.data(), bytes.size(), 0, 0, 1, [](long, long, int) {});
+  } catch (const char*) {
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Checks that packed grids whose cells would lie past the end of the file are rejected
+ */
+bool checkPackedGridCorrupt() {
+  return rejectsGrid(4, 9, 8) == false
+         && rejectsGrid(0, 0, 0) == false
+         && rejectsGrid(4, 9, 7)
+         // 2^61 rows of 8 bytes wrap around to 0
+         && rejectsGrid(1ULL << 61, 64, 0)
+         && rejectsGrid(4, 1ULL << 32, 64)
+         && rejectsGrid(~0ULL, 1, 64);
+}
+
+/**
+ * Records a run with the given keyframe period and replays it, comparing every
+ * generation replayed with the one computed
+ *
+ * @returns the number of keyframes following a delta replayed, -1 on a mismatch
+ */
+template<class G>
+int replayMismatch(const string& path, long height, long width, vector<int> input, long keyEvery, int steps) {
+  TestLife<G> game(height, width, 3, input);
+  vector<vector<int>> states = {cellsOf(game)};
+  {
+    DeltaRecorder recorder(path.c_str(), height, width, keyEvery);
+    game.setRecorder(&recorder);
+    for (int i = 0; i < steps; i++) {
+      game.run(1);
+      states.push_back(cellsOf(game));
+    }
+    game.setRecorder(nullptr);
+  }
+  DeltaPlayer player(path.c_str());
+  int keyframes = 0;
+  long last = -1;
+  while (player.next()) {
+    if (player.getGeneration() == last) keyframes++;
+    last = player.getGeneration();
+    if (last >= (long) states.size()) return -1;
+    for (long i = 0; i < height * width; i++) {
+      if (player.getCells()[i] != states[last][i]) return -1;
+    }
+  }
+  return last == steps ? keyframes : -1;
+}
+
+/**
+ * Records and replays a soup with periodic keyframes, and a still life whose
+ * deltas are all empty
+ */
+template<class G>
+bool checkDeltaRoundTrip() {
+  long height = 29, width = 71;
+  string path = tempPath("round.delta");
+  vector<int> block(height * width, 0);
+  block[5 * width + 5] = block[5 * width + 6] = block[6 * width + 5] = block[6 * width + 6] = 1;
+  bool ok = replayMismatch<G>(path, height, width, soup(height, width), 4, 13) == 3
+            && replayMismatch<G>(path, height, width, block, 0, 5) == 0;
+  unlink(path.c_str());
+  return ok;
+}
+
+/**
+ * Writes a recording of an 8 x 8 automaton made of the given records
+ *
+ * @returns true if replaying it throws
+ */
+bool rejectsDelta(const vector<uint8_t>& records) {
+  vector<uint8_t> bytes(DELTA_MAGIC, DELTA_MAGIC + sizeof(DELTA_MAGIC));
+  putLittleEndian(bytes, DELTA_VERSION, 4);
+  putLittleEndian(bytes, 0, 4);
+  putLittleEndian(bytes, 8, 8);
+  putLittleEndian(bytes, 8, 8);
+  bytes.insert(bytes.end(), records.begin(), records.end());
+  string path = tempPath("corrupt.delta");
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return false;
+  bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  fclose(file);
+  bool rejected = false;
+  try {
+    DeltaPlayer player(path.c_str());
+    while (player.next()) {}
+  } catch (const char*) {
+    rejected = true;
+  }
+  unlink(path.c_str());
+  return written && rejected;
+}
+
+/**
+ * @returns a record of a single segment holding the given data
+ */
+vector<uint8_t> deltaRecord(char type, uint64_t first, uint64_t count, vector<uint8_t> data) {
+  vector<uint8_t> record;
+  putLittleEndian(record, type, 1);
+  putLittleEndian(record, 1, 8);
+  putLittleEndian(record, 1, 4);
+  putLittleEndian(record, first, 8);
+  putLittleEndian(record, count, 8);
+  putLittleEndian(record, data.size(), 8);
+  record.insert(record.end(), data.begin(), data.end());
+  return record;
+}
+
+/**
+ * Checks that the deltas whose runs or segments lie outside the cells are
+ * rejected, as well as every truncation of a valid recording
+ */
+bool checkDeltaCorrupt() {
+  vector<uint8_t> literal = {0, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+  bool ok = !rejectsDelta(deltaRecord('D', 0, 64, literal))
+            && !rejectsDelta(deltaRecord('D', 0, 64, {1, 0}))
+            // runs past the end of the segment
+            && rejectsDelta(deltaRecord('D', 0, 64, {2, 0}))
+            && rejectsDelta(deltaRecord('D', 0, 64, {0, 2, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0}))
+            && rejectsDelta(deltaRecord('D', 32, 32, {1, 1, 1, 0, 0, 0, 0, 0, 0, 0}))
+            // literal or varint past the end of the data
+            && rejectsDelta(deltaRecord('D', 0, 64, {0, 1, 1, 0, 0}))
+            && rejectsDelta(deltaRecord('D', 0, 64, {0x80}))
+            && rejectsDelta(deltaRecord('D', 0, 64, {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 1, 0}))
+            // trailing bytes after the last run
+            && rejectsDelta(deltaRecord('D', 0, 64, {1, 0, 0}))
+            // segments outside the cells, also when first + count wraps around
+            && rejectsDelta(deltaRecord('D', 1, 64, {1, 0}))
+            && rejectsDelta(deltaRecord('D', ~0ULL, 2, {1, 0}))
+            && rejectsDelta(deltaRecord('K', 0, 64, {0, 0, 0, 0, 0, 0, 0}))
+            && rejectsDelta(deltaRecord('K', 0, 64, vector<uint8_t>(1 << 12, 0)));
+
+  string path = tempPath("valid.delta");
+  replayMismatch<threads1D_ints::Game>(path, 8, 8, soup(8, 8), 2, 4);
+  FILE* file = fopen(path.c_str(), "rb");
+  vector<uint8_t> valid(1 << 12);
+  valid.resize(file == nullptr ? 0 : fread(valid.data(), 1, valid.size(), file));
+  if (file != nullptr) fclose(file);
+  unlink(path.c_str());
+  // offsets at which the records of the valid recording end
+  vector<size_t> ends = {32};
+  for (size_t at = 32; at + 13 <= valid.size(); ends.push_back(at)) {
+    uint64_t segments = getLittleEndian(&valid[at + 9], 4);
+    at += 13;
+    for (uint64_t s = 0; s < segments; s++) {
+      at += 24 + getLittleEndian(&valid[at + 16], 8);
+    }
+  }
+  ok = ok && ends.size() > 5 && ends.back() == valid.size();
+  // a recording cut inside a record must be rejected
+  for (size_t n = 32; n < valid.size(); n++) {
+    bool boundary = find(ends.begin(), ends.end(), n) != ends.end();
+    ok = ok && rejectsDelta(vector<uint8_t>(valid.begin() + 32, valid.begin() + n)) != boundary;
+  }
+  return ok;
+}
+
+/**
+ * Streams a run to a raw file and to a full device: the frames must all be
+ * written to the file, and the failed writes must stop the run with an error
+ */
+template<class G>
+bool checkStreamErrors() {
+  long height = 64, width = 128;
+  string path = tempPath("frames.raw");
+  TestLife<G> game(height, width, 3, soup(height, width));
+  GenerationStream stream(height, width, 2, unique_ptr<FrameSink>(new RawFileSink(path.c_str())));
+  game.setStream(&stream);
+  game.run(9);
+  game.setStream(nullptr);
+  stream.close();
+  FILE* file = fopen(path.c_str(), "rb");
+  bool ok = file != nullptr && fseek(file, 0, SEEK_END) == 0 && ftell(file) == 5 * (24 + height * width);
+  if (file != nullptr) fclose(file);
+  unlink(path.c_str());
+
+  GenerationStream full(height, width, 1, unique_ptr<FrameSink>(new RawFileSink("/dev/full")));
+  game.setStream(&full);
+  bool thrown = false;
+  try {
+    game.run(1000);
+  } catch (const char*) {
+    thrown = true;
+  }
+  ok = ok && thrown && full.getError() != nullptr && game.getGeneration() < 9 + 1000;
+  game.setStream(nullptr);
+  thrown = false;
+  try {
+    full.close();
+  } catch (const char*) {
+    thrown = true;
+  }
+  return ok && thrown;
+}
+
+/**
+ * @returns true if a PgmSequenceSink rejects the given pattern of the paths
+ */
+bool rejectsPattern(const char* pattern) {
+  try {
+    PgmSequenceSink sink(pattern);
+  } catch (const char*) {
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Checks the patterns accepted by the PGM sequences, and that a video written
+ * to a full device stops the run with an error
+ */
+bool checkVideoErrors() {
+  bool ok = !rejectsPattern("frame%06ld.pgm") && !rejectsPattern("100%% %-+8.3ld")
+            && rejectsPattern("frame.pgm") && rejectsPattern("%s%ld") && rejectsPattern("%ld%ld")
+            && rejectsPattern("%n%ld") && rejectsPattern("%d") && rejectsPattern("%ld%");
+  long height = 64, width = 128;
+  TestLife<threads1D_ints::Game> game(height, width, 2, soup(height, width));
+  GenerationStream full(height, width, 1, unique_ptr<FrameSink>(new Y4MSink("/dev/full")));
+  game.setStream(&full);
+  bool thrown = false;
+  try {
+    game.run(1000);
+  } catch (const char*) {
+    thrown = true;
+  }
+  game.setStream(nullptr);
+  return ok && thrown && game.getGeneration() < 1000;
+}
+
+/**
+ * A check of a format
+ */
+struct FormatCheck {
+  string name;
+  bool (*check)();
+};
+
+const vector<FormatCheck> CHECKS = {
+  {"snapshot round trip ints_1D", checkSnapshotRoundTrip<threads1D_ints::Game>},
+  {"snapshot round trip cells_1D", checkSnapshotRoundTrip<threads1D_cells::Game>},
+  {"snapshot round trip ints_2D", checkSnapshotRoundTrip<threads2D_ints::Game>},
+  {"snapshot byte order", checkSnapshotByteOrder},
+  {"snapshot corrupt headers", checkSnapshotCorrupt},
+  {"packed grid round trip", checkPackedGridRoundTrip},
+  {"packed grid corrupt headers", checkPackedGridCorrupt},
+  {"delta round trip ints_1D", checkDeltaRoundTrip<threads1D_ints::Game>},
+  {"delta round trip ints_2D", checkDeltaRoundTrip<threads2D_ints::Game>},
+  {"delta corrupt records", checkDeltaCorrupt},
+  {"stream write errors ints_1D", checkStreamErrors<threads1D_ints::Game>},
+  {"stream write errors ints_2D", checkStreamErrors<threads2D_ints::Game>},
+  {"video patterns and write errors", checkVideoErrors},
+};
+
+int main() {
+  int failed = 0;
+  for (auto& c : CHECKS) {
+    bool ok = c.check();
+    cout << c.name << ": " << (ok ? "ok" : "FAILED") << endl;
+    failed += !ok;
+  }
+  return failed == 0 ? 0 : 1;
+}
@@ -8,9 +8,9 @@ using namespace std;
 
 int main(int argc, char* argv[]) {
   // args
-  if (argc != 5) {
+  if (argc < 5 || argc > 7) {
     cout << "Received " << argc - 1 << " of the minimum 4 arguments" << endl;
-    cout << "Usage is " << argv[0] << " height width num_workers num_steps" << endl;
+    cout << "Usage is " << argv[0] << " height width num_workers num_steps [num_runs [isolate]]" << endl;
     return(-1);
   }
 
@@ -46,13 +46,32 @@ int main(int argc, char* argv[]) {
     return(-1);
   }
 
+  // number of runs
+  auto n_runs = 5;
+  if (argc >= 6) {
+    n_runs = atoi(argv[5]);
+    if (n_runs <= 0) {
+      cout << "Number of runs must be > 0" << endl;
+      cout << "Usage is " << argv[0] << " height width num_workers num_steps [num_runs [isolate]]" << endl;
+      return(-1);
+    }
+  }
+
+  // measure each configuration in its own process
+  bool isolate = argc == 7 && atoi(argv[6]) != 0;
+
   srand(112233);
   vector<int> input (height * width);
   for (int i = 0; i < height * width; i++) {
     input[i] = rand() % 2;
   }
 
-  Benchmark b = Benchmark(height, width, input, max_workers, n_steps);
-  b.bench();
+  try {
+    Benchmark b = Benchmark(height, width, input, max_workers, n_steps, n_runs);
+    b.setIsolation(isolate);
+    b.bench();
+  } catch (const char* msg) {
+    cerr << msg << endl;
+  }
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+/**
+ * Checks the neighbourhood returned by every table implementation on boards
+ * which are not square, against the neighbours computed wrapping the rows
+ * modulo the height and the columns modulo the width.
+ *
+ * Compile from the root of the repository with
+ *   g++ -std=c++14 -pthread -I. testWrap.cpp -o testWrap
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench_engines.hpp"
+
+/**
+ * Compares the neighbourhoods of all the cells of a board
+ *
+ * @returns the number of cells with a wrong neighbourhood
+ */
+template<class T>
+long checkTable(long height, long width) {
+  vector<int> input(height * width);
+  for (long i = 0; i < height * width; i++) {
+    input[i] = (int) (i % 251);
+  }
+  T table(height, width, input);
+  long wrong = 0;
+  for (long r = 0; r < height; r++) {
+    for (long c = 0; c < width; c++) {
+      vector<int> expected;
+      for (long dr = -1; dr <= 1; dr++) {
+        for (long dc = -1; dc <= 1; dc++) {
+          if (dr == 0 && dc == 0) continue;
+          expected.push_back(input[((r + dr + height) % height) * width + (c + dc + width) % width]);
+        }
+      }
+      if (table.getNeighbours(r * width + c) != expected) wrong++;
+    }
+  }
+  return wrong;
+}
+
+/**
+ * A table implementation
+ */
+struct TableCheck {
+  string name;
+  long (*check)(long, long);
+};
+
+const vector<TableCheck> TABLES = {
+  {"ints_1D", checkTable<threads1D_ints::Table>},
+  {"cells_1D", checkTable<threads1D_cells::Table>},
+  {"ints_2D", checkTable<threads2D_ints::Table>},
+  {"cells_2D", checkTable<threads2D_cells::Table>},
+  {"ints_1D_ref", checkTable<ref1D_ints::Table>},
+};
+
+int main() {
+  const long sizes[][2] = {{7, 7}, {5, 12}, {12, 5}, {1, 9}, {9, 1}};
+  int failed = 0;
+  for (auto& t : TABLES) {
+    for (auto& s : sizes) {
+      long wrong = t.check(s[0], s[1]);
+      cout << t.name << " " << s[0] << "x" << s[1] << ": " << (wrong == 0 ? "ok" : "FAILED") << " (" << wrong
+           << " wrong neighbourhoods)" << endl;
+      failed += wrong != 0;
+    }
+  }
+  return failed == 0 ? 0 : 1;
+}
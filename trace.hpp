@@ -0,0 +1,162 @@
+/**
+ * Timeline tracing of the runs of the std::thread frameworks, exported in the
+ * Chrome trace event format (chrome://tracing, https://ui.perfetto.dev).
+ *
+ * Every worker records, for each generation, the interval spent computing its
+ * stripe and the interval spent at the barrier, from its arrival to its release;
+ * the thread coordinating the steps records the serial work done at the barrier
+ * and, inside it, the swap of the tables. Each thread writes only its own track,
+ * a ring of preallocated records keeping the latest ones, so that tracing takes
+ * no lock and no allocation during the run. Stragglers show as long compute
+ * intervals, barrier skew as staggered arrivals, and the wake-up latency as the
+ * distance between the end of the serial work and the release of the workers.
+ */
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// kinds of the traced intervals
+const int TRACE_COMPUTE = 0;
+const int TRACE_BARRIER = 1;
+const int TRACE_SERIAL = 2;
+const int TRACE_SWAP = 3;
+
+/**
+ * Interval of a generation, in nanoseconds since the creation of the Tracer
+ */
+struct TraceRecord {
+  int kind;
+  long generation;
+  int64_t start;
+  int64_t end;
+};
+
+/**
+ * Class holding the tracks of the workers and of the coordinator of a Game
+ */
+class Tracer {
+  private:
+    typedef chrono::high_resolution_clock TraceClock;
+
+    /**
+     * Ring of the records of a thread
+     */
+    struct Track {
+      vector<TraceRecord> records;
+      // number of records written, the latest ones being kept
+      uint64_t written;
+      // keeps the tracks of different threads on different cache lines
+      char padding[64];
+    };
+    vector<Track> tracks;
+    TraceClock::time_point origin;
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param nw number of workers of the traced Game, which has nw + 1 tracks,
+     * the last one being the coordinator
+     * @param capacity number of records kept per track
+     */
+    Tracer(int nw, long capacity = 4096) {
+      if (nw <= 0 || capacity <= 0) throw "Invalid parameters, check framework API";
+      tracks = vector<Track>(nw + 1);
+      for (auto& t : tracks) {
+        t.records = vector<TraceRecord>(capacity);
+        t.written = 0;
+      }
+      origin = TraceClock::now();
+    }
+
+    // Getters
+    int getWorkers() { return tracks.size() - 1; }
+    // number of records overwritten in the given track
+    uint64_t getLost(int track) {
+      uint64_t capacity = tracks[track].records.size();
+      return tracks[track].written > capacity ? tracks[track].written - capacity : 0;
+    }
+
+    /**
+     * Records an interval, called only by the thread owning the track
+     *
+     * @param track index of the worker, or number of workers for the coordinator
+     * @param kind TRACE_COMPUTE, TRACE_BARRIER, TRACE_SERIAL or TRACE_SWAP
+     * @param generation generation being computed
+     * @param start beginning of the interval
+     * @param end end of the interval
+     */
+    void record(int track, int kind, long generation, TraceClock::time_point start, TraceClock::time_point end) {
+      Track& t = tracks[track];
+      TraceRecord& r = t.records[t.written % t.records.size()];
+      r.kind = kind;
+      r.generation = generation;
+      r.start = chrono::duration_cast<chrono::nanoseconds>(start - origin).count();
+      r.end = chrono::duration_cast<chrono::nanoseconds>(end - origin).count();
+      t.written++;
+    }
+
+    /**
+     * @returns the records kept in the given track, oldest first
+     */
+    vector<TraceRecord> getRecords(int track) {
+      Track& t = tracks[track];
+      uint64_t capacity = t.records.size();
+      vector<TraceRecord> kept;
+      for (uint64_t k = t.written > capacity ? t.written - capacity : 0; k < t.written; k++) {
+        kept.push_back(t.records[k % capacity]);
+      }
+      return kept;
+    }
+
+    /**
+     * Discards the records of every track
+     */
+    void clear() {
+      for (auto& t : tracks) t.written = 0;
+    }
+
+    /**
+     * Writes the records as a Chrome trace JSON file, one thread per track. To be
+     * called when no run is in progress
+     *
+     * @param path path of the file
+     */
+    void save(const char* path) {
+      static const char* names[] = {"compute", "barrier", "serial", "swap"};
+      ofstream out(path);
+      if (!out) throw "Cannot open the output file";
+      int nw = getWorkers();
+      // timestamps in microseconds, with the nanoseconds as decimals
+      out << fixed << setprecision(3);
+      out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [" << endl;
+      for (int i = 0; i <= nw; i++) {
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+            << ", \"args\": {\"name\": \"" << (i < nw ? "worker " + to_string(i) : string("coordinator")) << "\"}}," << endl;
+      }
+      for (int i = 0; i <= nw; i++) {
+        for (auto& r : getRecords(i)) {
+          out << "{\"name\": \"" << names[r.kind] << "\", \"cat\": \"step\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << i
+              << ", \"ts\": " << r.start / 1000.0 << ", \"dur\": " << (r.end - r.start) / 1000.0
+              << ", \"args\": {\"generation\": " << r.generation << "}}," << endl;
+        }
+      }
+      // closing metadata event, so that every event above ends with a comma
+      out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"Game\"}}" << endl;
+      out << "]}" << endl;
+      if (!out) throw "Cannot write the output file";
+    }
+};
+
+#endif
@@ -0,0 +1,273 @@
+/**
+ * Sinks exporting the streamed generations as video frames.
+ *
+ * The frames are converted and written by the writer thread of the
+ * GenerationStream they are attached to, so encoding runs in its own stage and,
+ * with a stream dropping frames, never slows down the simulation. Each state is
+ * mapped to a colour of a palette, and the frames can be scaled up (scale x scale
+ * pixels per cell) or down (one pixel averaging a block x block square of cells).
+ *
+ * Supported outputs:
+ * - YUV4MPEG2 (.y4m) raw video, 4:4:4 chroma, which ffmpeg can encode offline
+ * - sequence of binary PGM images, one file per frame, in grey levels
+ */
+#ifndef VIDEO_HPP
+#define VIDEO_HPP
+
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "stream.hpp"
+
+using namespace std;
+
+/**
+ * Colour of a state
+ */
+struct Colour {
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+};
+
+/**
+ * @returns the default palette: dead cells black, alive cells white, further
+ * states in distinct colours
+ */
+inline vector<Colour> defaultPalette() {
+  return {{0, 0, 0}, {255, 255, 255}, {230, 60, 50}, {60, 180, 75}, {0, 130, 200},
+          {255, 225, 25}, {145, 30, 180}, {70, 240, 240}, {240, 50, 230}, {245, 130, 48}};
+}
+
+/**
+ * Class converting the cells of a frame into YUV 4:4:4 planes
+ */
+class FrameRaster {
+  private:
+    // BT.601 components of the colour of each state, studio range for the video
+    // and full range luma for grey images
+    vector<int> lumas;
+    vector<int> blues;
+    vector<int> reds;
+    vector<int> greys;
+    // pixels per side of a cell
+    long scale;
+    // cells per side of a pixel
+    long block;
+    // planes of the last frame
+    vector<uint8_t> y;
+    vector<uint8_t> u;
+    vector<uint8_t> v;
+    long frameHeight;
+    long frameWidth;
+
+    // index of the palette entry of a state
+    long entry(int state) {
+      long n = lumas.size();
+      return state < 0 ? 0 : state % n;
+    }
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param palette colour of each state, states past its end wrap around
+     * @param scale pixels per side of a cell
+     * @param block cells per side of a pixel
+     */
+    FrameRaster(const vector<Colour>& palette, long scale = 1, long block = 1): scale(scale), block(block) {
+      if (palette.empty() || scale <= 0 || block <= 0 || (scale > 1 && block > 1)) {
+        throw "Invalid parameters, check framework API";
+      }
+      for (auto& c : palette) {
+        lumas.push_back(16 + (65481 * c.red + 128553 * c.green + 24966 * c.blue) / 255000);
+        blues.push_back(128 + (-37797 * c.red - 74203 * c.green + 112000 * c.blue) / 255000);
+        reds.push_back(128 + (112000 * c.red - 93786 * c.green - 18214 * c.blue) / 255000);
+        greys.push_back((299 * c.red + 587 * c.green + 114 * c.blue) / 1000);
+      }
+      frameHeight = 0;
+      frameWidth = 0;
+    }
+
+    // Getters
+    long getFrameHeight() { return frameHeight; }
+    long getFrameWidth() { return frameWidth; }
+    const vector<uint8_t>& getY() { return y; }
+    const vector<uint8_t>& getU() { return u; }
+    const vector<uint8_t>& getV() { return v; }
+
+    /**
+     * Converts the cells of a frame, filling the planes
+     *
+     * @param cells row-major values of the cells
+     * @param height number of rows
+     * @param width number of columns
+     * @param grey whether to fill only the Y plane, with full range grey levels
+     */
+    void convert(const int* cells, long height, long width, bool grey) {
+      long rows = (height + block - 1) / block;
+      long columns = (width + block - 1) / block;
+      frameHeight = rows * scale;
+      frameWidth = columns * scale;
+      y.resize(frameHeight * frameWidth);
+      u.resize(grey ? 0 : y.size());
+      v.resize(grey ? 0 : y.size());
+      for (long r = 0; r < rows; r++) {
+        for (long c = 0; c < columns; c++) {
+          // average of the components over the block of cells
+          long sy = 0, su = 0, sv = 0, n = 0;
+          for (long i = r * block; i < (r + 1) * block && i < height; i++) {
+            for (long j = c * block; j < (c + 1) * block && j < width; j++) {
+              long e = entry(cells[i * width + j]);
+              sy += grey ? greys[e] : lumas[e];
+              if (!grey) {
+                su += blues[e];
+                sv += reds[e];
+              }
+              n++;
+            }
+          }
+          for (long i = r * scale; i < (r + 1) * scale; i++) {
+            long first = i * frameWidth + c * scale;
+            for (long j = 0; j < scale; j++) {
+              y[first + j] = sy / n;
+              if (!grey) {
+                u[first + j] = su / n;
+                v[first + j] = sv / n;
+              }
+            }
+          }
+        }
+      }
+    }
+};
+
+/**
+ * Sink writing the frames as a YUV4MPEG2 video
+ */
+class Y4MSink: public FrameSink {
+  private:
+    FILE* file;
+    int fps;
+    FrameRaster raster;
+    bool started;
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param path path of the video
+     * @param fps frames per second declared in the header
+     * @param scale pixels per side of a cell
+     * @param block cells per side of a pixel
+     * @param palette colour of each state
+     */
+    Y4MSink(const char* path, int fps = 30, long scale = 1, long block = 1,
+            const vector<Colour>& palette = defaultPalette()):
+      fps(fps), raster(palette, scale, block) {
+        if (fps <= 0) throw "Invalid parameters, check framework API";
+        file = fopen(path, "wb");
+        if (file == nullptr) throw "Cannot open the output file";
+        started = false;
+    }
+
+    // Destructor
+    ~Y4MSink() {
+      if (file != nullptr) fclose(file);
+    }
+
+    void write(long, const int* cells, long height, long width) {
+      raster.convert(cells, height, width, false);
+      if (!started) {
+        if (fprintf(file, "YUV4MPEG2 W%ld H%ld F%d:1 Ip A1:1 C444\n", raster.getFrameWidth(),
+                    raster.getFrameHeight(), fps) < 0) {
+          throw "Cannot write the output file";
+        }
+        started = true;
+      }
+      if (fputs("FRAME\n", file) < 0
+          || fwrite(raster.getY().data(), 1, raster.getY().size(), file) != raster.getY().size()
+          || fwrite(raster.getU().data(), 1, raster.getU().size(), file) != raster.getU().size()
+          || fwrite(raster.getV().data(), 1, raster.getV().size(), file) != raster.getV().size()) {
+        throw "Cannot write the output file";
+      }
+    }
+
+    void close() { closeSinkFile(file); }
+};
+
+/**
+ * Sink writing each frame as a binary PGM image
+ */
+class PgmSequenceSink: public FrameSink {
+  private:
+    // printf pattern of the paths, receiving the generation as a long
+    string pattern;
+    FrameRaster raster;
+    // number of frames whose file could not be created
+    long failed;
+
+    /**
+     * @returns true if the pattern holds exactly one conversion, of a long in
+     * decimal (%ld with optional flags, width and precision), besides any %%
+     */
+    static bool validPattern(const string& pattern) {
+      int conversions = 0;
+      for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] != '%') continue;
+        i++;
+        if (i < pattern.size() && pattern[i] == '%') continue;
+        while (i < pattern.size() && strchr("-+ #0", pattern[i]) != nullptr) i++;
+        while (i < pattern.size() && isdigit((unsigned char) pattern[i])) i++;
+        if (i < pattern.size() && pattern[i] == '.') {
+          i++;
+          while (i < pattern.size() && isdigit((unsigned char) pattern[i])) i++;
+        }
+        if (pattern.compare(i, 2, "ld") != 0) return false;
+        i++;
+        conversions++;
+      }
+      return conversions == 1;
+    }
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param pattern printf pattern of the paths, e.g. "frame%06ld.pgm", receiving
+     * the generation of the frame through its only conversion, which must be a %ld
+     * @param scale pixels per side of a cell
+     * @param block cells per side of a pixel
+     * @param palette colour of each state, converted to grey levels
+     */
+    PgmSequenceSink(const char* pattern, long scale = 1, long block = 1,
+                    const vector<Colour>& palette = defaultPalette()):
+      pattern(pattern), raster(palette, scale, block) {
+        if (!validPattern(this->pattern)) throw "Invalid parameters, check framework API";
+        failed = 0;
+    }
+
+    // Getters
+    long getFailed() { return failed; }
+
+    void write(long generation, const int* cells, long height, long width) {
+      raster.convert(cells, height, width, true);
+      vector<char> path(snprintf(nullptr, 0, pattern.c_str(), generation) + 1);
+      snprintf(path.data(), path.size(), pattern.c_str(), generation);
+      FILE* file = fopen(path.data(), "wb");
+      if (file == nullptr) {
+        failed++;
+        return;
+      }
+      bool written = fprintf(file, "P5\n%ld %ld\n255\n", raster.getFrameWidth(), raster.getFrameHeight()) >= 0
+                     && fwrite(raster.getY().data(), 1, raster.getY().size(), file) == raster.getY().size();
+      closeSinkFile(file);
+      if (!written) throw "Cannot write the output file";
+    }
+};
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * Read-only view over the cells of a generation, giving access to the values
+ * stored in the table without copying them.
+ */
+#ifndef VIEW_HPP
+#define VIEW_HPP
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * Class representing a rectangle of cells of the table
+ *
+ * The values of a row are found at a fixed distance in bytes from each other,
+ * which is sizeof(int) for the ints tables and the size of a Cell for the cells
+ * tables. A view refers to the memory of the table: it is valid until the next
+ * step of the Game, which swaps the future generation in
+ */
+class GridView {
+  private:
+    // first value of each row of the view
+    vector<const char*> rows;
+    long height;
+    long width;
+    // distance in bytes between two consecutive values of a row
+    long step;
+
+  public:
+    // Default constructor
+    GridView(): height(0), width(0), step(sizeof(int)) {}
+
+    /**
+     * Constructor of an empty view, the rows must then be added with addRow
+     *
+     * @param width number of columns
+     * @param step distance in bytes between two consecutive values of a row
+     */
+    GridView(long width, long step): height(0), width(width), step(step) {}
+
+    /**
+     * Appends a row to the view
+     *
+     * @param first address of the value of the first cell of the row
+     */
+    void addRow(const int* first) {
+      rows.push_back((const char*) first);
+      height++;
+    }
+
+    // Getters
+    long getHeight() const { return height; }
+    long getWidth() const { return width; }
+    long getStep() const { return step; }
+
+    /**
+     * @returns the value of the cell at the given row and column of the view
+     */
+    int operator()(long row, long column) const {
+      return *(const int*) (rows[row] + column * step);
+    }
+
+    /**
+     * @returns true if the values of a row are consecutive ints, so that
+     * getRow can be read as an array of width ints
+     */
+    bool isContiguous() const { return step == sizeof(int); }
+
+    /**
+     * @returns the address of the value of the first cell of the given row
+     */
+    const int* getRow(long row) const { return (const int*) rows[row]; }
+
+    /**
+     * Returns a view over a rectangle of this view
+     *
+     * @param row first row of the rectangle
+     * @param column first column of the rectangle
+     * @param h number of rows of the rectangle
+     * @param w number of columns of the rectangle
+     */
+    GridView sub(long row, long column, long h, long w) const {
+      if (row < 0 || column < 0 || h < 0 || w < 0 || row + h > height || column + w > width) {
+        throw "Invalid parameters, check framework API";
+      }
+      GridView view(w, step);
+      for (long i = row; i < row + h; i++) {
+        view.addRow((const int*) (rows[i] + column * step));
+      }
+      return view;
+    }
+};
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * Standard corpus of reproducible workloads for the benchmarks, selectable by
+ * name.
+ *
+ * Uniform soups only exercise the engines with a grid where every region is
+ * equally active; the corpus also includes sparse and localized activity, on
+ * which the optimizations of active regions and sparse grids show up:
+ * - soupN: random soup with N% of live cells (soup10, soup25, soup50, soup75)
+ * - sparse: random soup with 1% of live cells
+ * - rpentomino, acorn: methuselahs, a small pattern in the center of the grid
+ *   growing for thousands of generations
+ * - gliderguns: Gosper glider guns tiled on the grid, emitting gliders which
+ *   collide with each other
+ * - growth: 5x5 pattern of infinite growth in the center of the grid
+ * - dead, alive: grids of only dead or only live cells
+ * The soups depend on the seed, through the counter-based generator of
+ * random.hpp, the patterns only on the dimensions of the grid.
+ */
+#ifndef WORKLOADS_HPP
+#define WORKLOADS_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "random.hpp"
+#include "loaders.hpp"
+
+using namespace std;
+
+const char R_PENTOMINO[] =
+  ".OO\n"
+  "OO.\n"
+  ".O.\n";
+
+const char ACORN[] =
+  ".O.....\n"
+  "...O...\n"
+  "OO..OOO\n";
+
+const char GOSPER_GUN[] =
+  "........................O...........\n"
+  "......................O.O...........\n"
+  "............OO......OO............OO\n"
+  "...........O...O....OO............OO\n"
+  "OO........O.....O...OO..............\n"
+  "OO........O...O.OO....O.O...........\n"
+  "..........O.....O.......O...........\n"
+  "...........O...O....................\n"
+  "............OO......................\n";
+
+const char INFINITE_GROWTH[] =
+  "OOO.O\n"
+  "O....\n"
+  "...OO\n"
+  ".OO.O\n"
+  "O.O.O\n";
+
+/**
+ * @returns the names of the workloads of the corpus
+ */
+inline vector<string> workloadNames() {
+  return {"soup10", "soup25", "soup50", "soup75", "sparse", "rpentomino", "acorn", "gliderguns", "growth",
+          "dead", "alive"};
+}
+
+/**
+ * Places a plaintext pattern on a grid, wrapping around its edges
+ */
+inline void placePattern(vector<int>& cells, long height, long width, const char* pattern, long row, long column) {
+  loadPlaintext(pattern, strlen(pattern), row, column, 1, [&](long r, long c, int value) {
+    cells[((r % height + height) % height) * width + (c % width + width) % width] = value;
+  });
+}
+
+/**
+ * Generates a workload of the corpus
+ *
+ * @param name name of the workload, soupN for any percentage N of live cells
+ * @param height number of rows
+ * @param width number of columns
+ * @param seed seed of the soups
+ * @returns the row-major cells
+ */
+inline vector<int> workload(const string& name, long height, long width, uint64_t seed = 112233) {
+  if (height <= 0 || width <= 0) throw "Invalid parameters, check framework API";
+  vector<int> cells(height * width, 0);
+  double density = -1;
+  if (name == "sparse") density = 0.01;
+  else if (name.compare(0, 4, "soup") == 0 && name.size() > 4) {
+    char* end;
+    density = strtod(name.c_str() + 4, &end) / 100;
+    if (*end != 0 || density < 0 || density > 1) throw "Unknown workload";
+  }
+  if (density >= 0) {
+    uint64_t threshold = densityThreshold(density);
+    for (long i = 0; i < height * width; i++) {
+      cells[i] = randomCell(seed, threshold, i);
+    }
+  }
+  else if (name == "alive") fill(cells.begin(), cells.end(), 1);
+  else if (name == "rpentomino" || name == "acorn" || name == "growth") {
+    const char* pattern = name == "rpentomino" ? R_PENTOMINO : name == "acorn" ? ACORN : INFINITE_GROWTH;
+    long rows = name == "acorn" ? 3 : name == "growth" ? 5 : 3;
+    long columns = name == "acorn" ? 7 : name == "growth" ? 5 : 3;
+    if (height < rows + 2 || width < columns + 2) throw "The workload does not fit in the grid";
+    placePattern(cells, height, width, pattern, (height - rows) / 2, (width - columns) / 2);
+  }
+  else if (name == "gliderguns") {
+    // one gun every 48 rows and 64 columns, leaving room to the gliders
+    if (height < 11 || width < 38) throw "The workload does not fit in the grid";
+    for (long r = 1; r + 10 <= height; r += 48) {
+      for (long c = 1; c + 37 <= width; c += 64) {
+        placePattern(cells, height, width, GOSPER_GUN, r, c);
+      }
+    }
+  }
+  else if (name != "dead") throw "Unknown workload";
+  return cells;
+}
+
+#endif